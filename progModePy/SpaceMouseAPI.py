@@ -18,6 +18,11 @@ class ParamType(Enum):
     BOOL = 1
     INT = 2
     FLOAT = 3
+    BYTE = 4
+
+# parameter numbers of the elements of the array parameters, see spacemouse-keys/parameterMenu.h
+ARRAY_PARAM_BASE = 100
+ARRAY_PARAM_STRIDE = 100
 
 class SpaceMouseAPI:
     def __init__(self):
@@ -25,6 +30,7 @@ class SpaceMouseAPI:
         self.ser = None
         self.magicNumber = None
         self.numberParameters = None
+        self.numberArrayParameters = None
         self.actParamNo = None 
 
     def connect(self, port: str = None, baudrate: int = 115200, timeout: float = 1.0):
@@ -228,6 +234,19 @@ class SpaceMouseAPI:
             logging.error(f"Number of parameters not found. Error:{0}".format(ret))
             return None     
 
+    def getNumberArrayParameters(self):
+        ret = self.sendCommand(cmd='a')
+        if isinstance(ret, int) and not isinstance(ret, bool):
+            self.numberArrayParameters = ret
+            return self.numberArrayParameters
+        elif isinstance(ret, bool):
+            # "0" and "1" are interpreted as bool
+            self.numberArrayParameters = int(ret)
+            return self.numberArrayParameters
+        else:
+            logging.error(f"Number of array parameters not found. Error:{0}".format(ret))
+            return None
+
     def setParameterNumber(self, paramNo):
         if paramNo is None:
             logging.error('No Param No. provided')
@@ -235,7 +254,7 @@ class SpaceMouseAPI:
         if self.numberParameters is None:
             self.getNumberParameters()
 
-        if paramNo<1 or paramNo>self.numberParameters:
+        if (paramNo<1 or paramNo>self.numberParameters) and paramNo<ARRAY_PARAM_BASE:
             #number 0 is not used!
             logging.error(f"Parameter Number {0} not in range 0 to {1}".format(paramNo, self.numberParameters))
 
@@ -329,8 +348,8 @@ class SpaceMouseAPI:
         elif (paramType == ParamType.BOOL) and isinstance(value, (int,float)):
             value_str = 1 if value==1 else 0 
             logging.debug("Write Value {0}".format(value_str))
-        elif (paramType == ParamType.INT) and isinstance(value, (int, float)):
-            value_str = "{0:d}".format(value)
+        elif (paramType in (ParamType.INT, ParamType.BYTE)) and isinstance(value, (int, float)):
+            value_str = "{0:d}".format(int(value))
             logging.debug("Write Value {0}".format(value_str))
         elif (paramType == ParamType.FLOAT) and isinstance(value, (int, float)):
             value_str = "{0:.4f}".format(value)
@@ -340,9 +359,36 @@ class SpaceMouseAPI:
             return False
         return self.sendCommand(cmd='w',value=value_str)  
             
+    def readArray(self, arrayNo):
+        """Read all elements of the array parameter arrayNo (0 = first array). Returns a list of ints."""
+        first = ARRAY_PARAM_BASE + arrayNo * ARRAY_PARAM_STRIDE
+        values = []
+        # the array ends, where the parameter number gets invalid
+        while self.setParameterNumber(first + len(values)):
+            values.append(int(self.readValue()))
+        return values
+
+    def writeArray(self, arrayNo, values):
+        """Write a list of ints to the elements of the array parameter arrayNo (0 = first array)."""
+        first = ARRAY_PARAM_BASE + arrayNo * ARRAY_PARAM_STRIDE
+        for i, value in enumerate(values):
+            if self.writeValue(paramNo=first + i, value=int(value)) != ProgmodeError.PE_OK:
+                logging.error("Writing element {0} of array {1} failed".format(i, arrayNo))
+                return False
+        return True
+
+    def getArrayDescription(self, arrayNo):
+        """Name of the array parameter arrayNo, without the element index."""
+        ret = self.getParameterDescription(ARRAY_PARAM_BASE + arrayNo * ARRAY_PARAM_STRIDE)
+        if isinstance(ret, str):
+            return ret.split('[')[0]
+        return None
+
     def printAllParams(self):
         for i in range(1,sm.getNumberParameters()):
             print(f"#{i}: {sm.getParameterDescription(i)} <{sm.getParameterType(i).name}> = {sm.readValue(i)} ")
+        for a in range(0, sm.getNumberArrayParameters()):
+            print(f"#{ARRAY_PARAM_BASE + a * ARRAY_PARAM_STRIDE}: {sm.getArrayDescription(a)} = {sm.readArray(a)} ")
 
     def printParam(self, paramNo):
         print(f"#{paramNo}: {sm.getParameterDescription(paramNo)} <{sm.getParameterType(paramNo).name}> = {sm.readValue(paramNo)} ")
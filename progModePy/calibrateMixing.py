@@ -0,0 +1,223 @@
+# Guided calibration of the mixing matrix of the space mouse
+#
+# The firmware combines the eight centered values of the joysticks or hall effect sensors into the six axes
+# with the mixing matrix MIX and the shifts MIX_SHIFT (see README.md "Mixing matrix").
+# The default matrices only contain the ideal equations of the movement table in kinematics.cpp. Real sensors
+# show cross-talk: e.g. pushing the knob down produces some ghost rotations.
+#
+# This script
+# 1. reads the actual mixing matrix via the ProgMode
+# 2. guides you through the twelve reference motions (+/- for each of the six axes),
+#    while the firmware streams the input values of the matrix (debug mode 21)
+# 3. solves a least-squares fit for a new matrix: every axis shall follow the response of the actual matrix
+#    on its own motions and shall stay zero during all other motions
+# 4. scales every axis (gain), quantizes the matrix to int8 with one shift per row and writes it back via ProgMode
+#
+# usage: python calibrateMixing.py /dev/ttyACM0 [--seconds 4] [--gain keep|full] [--save]
+#
+# Prerequisites: pip install pyserial numpy
+# Calibrate the centers, deadzone and min/max values first, the matrix is calibrated on top of them.
+
+import argparse
+import logging
+import time
+
+import numpy as np
+
+from SpaceMouseAPI import SpaceMouseAPI
+
+# index of the array parameters, see par.arrays in spacemouse-keys.ino
+ARRAY_MIX = 0
+ARRAY_MIX_SHIFT = 1
+
+AXES = ["TX", "TY", "TZ", "RX", "RY", "RZ"]
+
+# reference motions: (axis index, description), see the movement table in kinematics.cpp
+MOTIONS = [
+    (0, "move the knob to the west / left         (TX)"),
+    (0, "move the knob to the east / right        (TX)"),
+    (1, "move the knob to the north / away        (TY)"),
+    (1, "move the knob to the south / towards you (TY)"),
+    (2, "pull the knob up                         (TZ)"),
+    (2, "push the knob down                       (TZ)"),
+    (3, "tilt the knob forward                    (RX)"),
+    (3, "tilt the knob backward                   (RX)"),
+    (4, "tilt the knob to the left                (RY)"),
+    (4, "tilt the knob to the right               (RY)"),
+    (5, "twist the knob clockwise                 (RZ)"),
+    (5, "twist the knob counterclockwise          (RZ)"),
+]
+
+# frames below this fraction of the largest deflection of a motion are not used (knob at rest or in transition)
+ACTIVE_FRACTION = 0.3
+
+# full scale of the axes after the sensitivity, see TOTALSENSITIVITY in kinematics.cpp
+TOTALSENSITIVITY = 350
+
+
+def mix(matrix, shifts, frames):
+    """Calculate the velocities of the frames like _calculateKinematicSensors() in kinematics.cpp"""
+    sums = frames.astype(np.int64) @ matrix.T.astype(np.int64)
+    divisor = 2 ** shifts.astype(np.int64)
+    return np.sign(sums) * (np.abs(sums) // divisor)
+
+
+def record(sm, seconds):
+    """Stream the values of debug mode 21 for some seconds and return them as array (frames x 8)"""
+    sm.ser.reset_input_buffer()
+    sm.ser.write(b"21\r\n")
+    frames = []
+    end = time.time() + seconds
+    while time.time() < end:
+        line = sm.ser.readline().decode("utf-8", errors="ignore").strip()
+        if line.startswith("{") and line.endswith("}"):
+            values = [int(v) for v in line[1:-1].split(",")]
+            if len(values) == 8:
+                frames.append(values)
+    # leave the debug mode and get back to the menu
+    sm.quitAndFlush()
+    return np.array(frames, dtype=np.int64).reshape(-1, 8)
+
+
+def quantize(rows):
+    """Quantize a float matrix (6 x 8) to int8 coefficients and one right shift per row"""
+    matrix = np.zeros((6, 8), dtype=np.int64)
+    shifts = np.zeros(6, dtype=np.int64)
+    for r in range(6):
+        largest = np.max(np.abs(rows[r]))
+        shift = 0
+        if largest == 0:
+            continue
+        # use the largest shift, which keeps all coefficients of the row within -128 ... 127
+        while shift < 15 and largest * 2 ** (shift + 1) <= 127:
+            shift += 1
+        shifts[r] = shift
+        matrix[r] = np.clip(np.round(rows[r] * 2 ** shift), -128, 127)
+    return matrix, shifts
+
+
+def crosstalk(velocities, axisOfFrame):
+    """Ratio of the rms of all other axes to the rms of the wanted axis, for each axis in %"""
+    result = []
+    for a in range(6):
+        sel = axisOfFrame == a
+        if not np.any(sel):
+            result.append(float("nan"))
+            continue
+        wanted = np.sqrt(np.mean(velocities[sel, a].astype(float) ** 2))
+        others = np.sqrt(np.mean(np.delete(velocities[sel], a, axis=1).astype(float) ** 2))
+        result.append(100.0 * others / wanted if wanted > 0 else float("inf"))
+    return result
+
+
+def main():
+    parser = argparse.ArgumentParser(description="Guided calibration of the mixing matrix of the space mouse")
+    parser.add_argument("port", help="serial port of the space mouse, e.g. /dev/ttyACM0 or COM5")
+    parser.add_argument("--seconds", type=float, default=4.0, help="recording time for each motion")
+    parser.add_argument("--gain", choices=["keep", "full"], default="keep",
+                        help="keep: keep the response of the actual matrix on each axis, "
+                             "full: scale each axis to reach +/-350 after the sensitivity at full deflection")
+    parser.add_argument("--save", action="store_true", help="save the parameters to the EEPROM afterwards")
+    parser.add_argument("--dry-run", action="store_true", help="only calculate and print, don't write to the mouse")
+    args = parser.parse_args()
+
+    logging.basicConfig(level=logging.ERROR, format='[%(levelname)s] %(message)s')
+
+    sm = SpaceMouseAPI()
+    sm.connect(args.port)
+    if sm.ser is None:
+        return
+
+    # actual matrix, used to define the wanted response of every axis
+    oldMatrix = np.array(sm.readArray(ARRAY_MIX), dtype=np.int64)
+    oldShifts = np.array(sm.readArray(ARRAY_MIX_SHIFT), dtype=np.int64)
+    if oldMatrix.size != 48 or oldShifts.size != 6:
+        print("The firmware doesn't provide the mixing matrix. Please update the firmware.")
+        return
+    oldMatrix = oldMatrix.reshape(6, 8)
+
+    # sensitivities of the axes, for --gain full: SENS_TX, SENS_TY, SENS_PTZ, SENS_RX, SENS_RY, SENS_RZ
+    sensitivities = [sm.readValue(n) for n in (2, 3, 4, 10, 11, 12)]
+
+    print("Calibration of the mixing matrix")
+    print("For every motion: press enter, then move the knob several times from the rest position to the")
+    print("full deflection in the given direction and back, until the recording stops.")
+    frames = []
+    axisOfFrame = []
+    weights = []
+    for axis, description in MOTIONS:
+        input(f"\n{description} - press enter to start ")
+        data = record(sm, args.seconds)
+        magnitude = np.max(np.abs(data), axis=1) if len(data) else np.array([])
+        if len(data) == 0 or magnitude.max() == 0:
+            print("  no movement recorded, this motion is skipped")
+            continue
+        active = data[magnitude >= ACTIVE_FRACTION * magnitude.max()]
+        print(f"  {len(active)} frames recorded")
+        frames.append(active)
+        axisOfFrame.append(np.full(len(active), axis))
+        # every motion has the same weight in the fit, independent of the number of frames
+        weights.append(np.full(len(active), 1.0 / np.sqrt(len(active))))
+
+    if len(frames) == 0:
+        print("Nothing recorded.")
+        return
+    frames = np.vstack(frames)
+    axisOfFrame = np.concatenate(axisOfFrame)
+    weights = np.concatenate(weights)
+
+    # wanted velocities: the response of the actual matrix on the own axis, zero on all other axes
+    oldVelocities = mix(oldMatrix, oldShifts, frames)
+    target = np.zeros((len(frames), 6))
+    for a in range(6):
+        sel = axisOfFrame == a
+        target[sel, a] = oldVelocities[sel, a]
+        if not np.any(sel):
+            print(f"Warning: no motion recorded for {AXES[a]}, the fit keeps this axis at zero")
+
+    # least-squares fit: frames @ rows.T = target
+    solution, _, rank, _ = np.linalg.lstsq(frames * weights[:, None], target * weights[:, None], rcond=None)
+    if rank < 8:
+        print("Warning: the recorded motions don't excite all eight sensors, the fit may be unreliable")
+    rows = solution.T
+
+    # gain of every axis
+    for a in range(6):
+        sel = axisOfFrame == a
+        if not np.any(sel):
+            continue
+        if args.gain == "full":
+            response = np.percentile(np.abs(frames[sel] @ rows[a]), 95)
+            if response > 0:
+                rows[a] *= TOTALSENSITIVITY * abs(sensitivities[a]) / response
+
+    newMatrix, newShifts = quantize(rows)
+    newVelocities = mix(newMatrix, newShifts, frames)
+
+    print("\ncross-talk (rms of the other axes / rms of the moved axis):")
+    oldCt = crosstalk(oldVelocities, axisOfFrame)
+    newCt = crosstalk(newVelocities, axisOfFrame)
+    for a in range(6):
+        print(f"  {AXES[a]}: {oldCt[a]:6.1f} % -> {newCt[a]:6.1f} %")
+
+    print("\nnew parameters:")
+    print("#define MIX {" + ", ".join(str(int(v)) for v in newMatrix.flatten()) + "}")
+    print("#define MIX_SHIFT {" + ", ".join(str(int(v)) for v in newShifts) + "}")
+
+    if args.dry_run:
+        return
+    if not sm.writeArray(ARRAY_MIX, newMatrix.flatten()) or not sm.writeArray(ARRAY_MIX_SHIFT, newShifts):
+        print("Writing the matrix failed.")
+        return
+    print("Matrix written.")
+    print("With a decoupled matrix, EXCLUSIVE and EXCL_PRIOZ are usually not necessary anymore.")
+    if args.save:
+        sm.saveParamsToEEPROM()
+        print("Parameters saved to the EEPROM.")
+    else:
+        print("The parameters are not saved yet: use --save or save them in the parameter menu.")
+    sm.close()
+
+
+if __name__ == '__main__':
+    main()
@@ -0,0 +1,144 @@
+# Read and write all parameters of the space mouse via the HID parameter report (linux hidraw)
+#
+# The firmware must be compiled with ADV_HID_PARAMS (see config_sample.h). Then feature report 8 carries
+# the magic number, a command byte and the whole ParamStorage block (see spacemouse-keys/parameterMenu.h).
+# In contrast to the ProgMode, no serial interface is needed and all parameters are transferred at once.
+#
+# usage:
+#   python hidParams.py list                            list the space mice found via hidraw
+#   python hidParams.py dump params.bin [--device ...]  read the parameters of a mouse into a file
+#   python hidParams.py load params.bin [--save] [--all | --device ...]
+#                                                       write the parameters from a file to a mouse or
+#                                                       to all connected mice, --save stores them in the EEPROM
+#
+# The file contains the report without the report id: magic number, command byte and ParamStorage.
+# The parameters are only written to mice with the same magic number, i.e. the same layout of ParamStorage.
+#
+# Prerequisites: read and write access to /dev/hidraw*, e.g. by an udev rule or by running as root
+
+import argparse
+import fcntl
+import glob
+import os
+import struct
+import sys
+
+# see spacemouse-keys/SpaceMouseHID.h
+HIDPARAMREPORT_ID = 8
+HIDPARAM_SAVE = 1
+
+# USB IDs of the emulated space mice, see set_hwids.py
+KNOWN_IDS = [(0x256f, 0xc631), (0x046d, 0xc626)]
+
+# largest report to expect, the actual length is given by the device
+MAX_REPORT_LEN = 1024
+
+
+def _ioc(direction, number, size):
+    """Calculate an ioctl request number like the _IOC() macro of linux"""
+    return (direction << 30) | (size << 16) | (ord('H') << 8) | number
+
+
+def HIDIOCSFEATURE(length):
+    return _ioc(3, 0x06, length)
+
+
+def HIDIOCGFEATURE(length):
+    return _ioc(3, 0x07, length)
+
+
+def findDevices():
+    """Return the hidraw devices of all connected space mice"""
+    devices = []
+    for path in sorted(glob.glob("/sys/class/hidraw/hidraw*")):
+        try:
+            with open(os.path.join(path, "device", "uevent")) as f:
+                uevent = f.read()
+        except OSError:
+            continue
+        for line in uevent.splitlines():
+            if line.startswith("HID_ID="):
+                # HID_ID=0003:0000256F:0000C631
+                _, vid, pid = line[len("HID_ID="):].split(":")
+                if (int(vid, 16), int(pid, 16)) in KNOWN_IDS:
+                    devices.append("/dev/" + os.path.basename(path))
+    return devices
+
+
+def readParams(device):
+    """Read the parameter report, return it without the report id"""
+    buf = bytearray(MAX_REPORT_LEN)
+    buf[0] = HIDPARAMREPORT_ID
+    with open(device, "rb+", buffering=0) as f:
+        length = fcntl.ioctl(f, HIDIOCGFEATURE(len(buf)), buf, True)
+    if length < 6 or buf[0] != HIDPARAMREPORT_ID:
+        raise IOError(f"{device}: no parameter report, is the firmware compiled with ADV_HID_PARAMS?")
+    return bytes(buf[1:length])
+
+
+def writeParams(device, report, save):
+    """Write a parameter report (without report id), if the magic number of the device is the same"""
+    actual = readParams(device)
+    if actual[0:4] != report[0:4] or len(actual) != len(report):
+        raise IOError(f"{device}: different magic number or length, the layout of the parameters doesn't match")
+    buf = bytearray([HIDPARAMREPORT_ID]) + bytearray(report)
+    buf[5] = HIDPARAM_SAVE if save else 0
+    with open(device, "rb+", buffering=0) as f:
+        fcntl.ioctl(f, HIDIOCSFEATURE(len(buf)), buf, True)
+
+
+def magicOf(report):
+    return struct.unpack("<l", report[0:4])[0]
+
+
+def main():
+    parser = argparse.ArgumentParser(description="Read and write the parameters of the space mouse via hidraw")
+    parser.add_argument("command", choices=["list", "dump", "load"])
+    parser.add_argument("file", nargs="?", help="file for the parameters")
+    parser.add_argument("--device", help="hidraw device, e.g. /dev/hidraw3. Default: the first space mouse found")
+    parser.add_argument("--all", action="store_true", help="load: write to all connected space mice")
+    parser.add_argument("--save", action="store_true", help="load: save the parameters to the EEPROM")
+    args = parser.parse_args()
+
+    devices = [args.device] if args.device else findDevices()
+    if len(devices) == 0:
+        print("No space mouse found.")
+        return 1
+
+    if args.command == "list":
+        for device in devices:
+            try:
+                report = readParams(device)
+                print(f"{device}: magic number {magicOf(report)}, {len(report) - 5} bytes of parameters")
+            except IOError as e:
+                print(e)
+        return 0
+
+    if args.file is None:
+        parser.error("a file is needed for dump and load")
+
+    if args.command == "dump":
+        report = readParams(devices[0])
+        with open(args.file, "wb") as f:
+            f.write(report)
+        print(f"{devices[0]}: {len(report) - 5} bytes of parameters written to {args.file}")
+        return 0
+
+    with open(args.file, "rb") as f:
+        report = f.read()
+    if len(report) < 6:
+        print(f"{args.file} contains no parameters")
+        return 1
+    failed = 0
+    for device in (devices if args.all else devices[0:1]):
+        try:
+            writeParams(device, report, args.save)
+            print(f"{device}: parameters written" + (" and saved" if args.save else ""))
+        except IOError as e:
+            print(e)
+            failed += 1
+    return 1 if failed else 0
+
+
+if __name__ == '__main__':
+    sys.exit(main())
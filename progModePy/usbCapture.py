@@ -0,0 +1,448 @@
+# Decode the HID reports of a space mouse from USB captures and compare them
+#
+# A capture of a real SpaceNavigator (see Reverse-Engineering-Docs/) shows, what the drivers expect: the layout of the
+# reports, the output reports of the host (LED) and the SET_REPORT requests (e.g. "Calibrate"). This script turns such
+# a capture into a stream of typed reports, measures the cadence of the reports and compares two streams, e.g. the
+# original device against the firmware.
+#
+# Sources:
+#   *.pcapng / *.pcap   captures of Wireshark with USBPcap (windows) or usbmon (linux)
+#   *.log / *.txt       the serial output of the firmware in debug mode 72: "R <time in us> <report id> <data>" in hex
+#
+# usage:
+#   python usbCapture.py decode capture.pcapng            print every report with time, type and decoded values
+#   python usbCapture.py cadence capture.pcapng           statistics of the intervals between the reports per report id
+#   python usbCapture.py compare reference.pcapng firmware.log [--exact]
+#                                                         compare report ids, lengths and cadence of two sources,
+#                                                         --exact also compares the data of the input reports
+#   python usbCapture.py record /dev/ttyACM0 firmware.log [--seconds 10]
+#                                                         record the reports of the firmware via debug mode 72
+#
+# Options: --device <address> selects the USB device in a capture with several devices, --all-devices keeps all.
+# Without it, the device with the most HID reports is used.
+#
+# test/test_usbCapture.py uses the functions of this script to compare the reports of the firmware on the PC with the
+# capture of the SpaceNavigator in Reverse-Engineering-Docs/.
+#
+# Prerequisites: pip install pyserial (only for record)
+
+import argparse
+import struct
+import sys
+import time
+
+# link types of the captures
+LINKTYPE_USBPCAP = 249
+LINKTYPE_USB_LINUX = 189
+LINKTYPE_USB_LINUX_MMAPPED = 220
+
+# transfer types of USBPcap and usbmon
+TRANSFER_INTERRUPT = 1
+TRANSFER_CONTROL = 2
+
+# HID class requests, see HID.h of the Arduino core
+HID_GET_REPORT = 0x01
+HID_SET_REPORT = 0x09
+REPORT_TYPES = {1: "input", 2: "output", 3: "feature"}
+
+# standard requests and descriptor types
+GET_DESCRIPTOR = 0x06
+DESCRIPTOR_CONFIGURATION = 0x02
+DESCRIPTOR_ENDPOINT = 0x05
+DESCRIPTOR_HID_REPORT = 0x22
+
+# report ids, see SpaceMouseHID.h
+REPORT_NAMES = {1: "axes", 2: "rotation", 3: "keys", 4: "LED", 7: "calibrate", 8: "parameters"}
+
+
+class Report:
+    """One HID report: time in s, direction ('in': device to host, 'out': host to device),
+    transfer ('interrupt' or 'SET_REPORT'), the report data including the report id and the USB device address"""
+
+    def __init__(self, time, direction, transfer, data, device=None):
+        self.time = time
+        self.direction = direction
+        self.transfer = transfer
+        self.data = bytes(data)
+        self.device = device
+
+    @property
+    def id(self):
+        return self.data[0] if self.data else None
+
+    def decode(self):
+        """Return the values of the report as text, like the firmware fills them in send_command()"""
+        payload = self.data[1:]
+        if self.direction == "in" and self.id in (1, 2) and len(payload) in (6, 12, 16):
+            axes = struct.unpack("<%dh" % min(len(payload) // 2, 6), payload[:min(len(payload), 12)])
+            if self.id == 2:
+                names = ["RX", "RY", "RZ"]
+            else:
+                names = ["TX", "TY", "TZ", "RX", "RY", "RZ"]
+            text = " ".join(f"{n}={v}" for n, v in zip(names, axes))
+            if len(payload) == 16:  # ADV_HID_COMBINED: the keys follow the axes
+                text += " keys=" + keysOf(payload[12:])
+            return text
+        if self.direction == "in" and self.id == 3:
+            return "keys=" + keysOf(payload)
+        if self.direction == "out" and self.id == 4 and payload:
+            return "LED " + ("on" if payload[0] & 1 else "off")
+        return payload.hex(" ")
+
+    def name(self):
+        return REPORT_NAMES.get(self.id, f"report {self.id}")
+
+
+def keysOf(data):
+    """The numbers of the pressed buttons (1 = first button), e.g. '1,5' or '-'"""
+    bits = int.from_bytes(data, "little")
+    pressed = [str(i + 1) for i in range(len(data) * 8) if bits & (1 << i)]
+    return ",".join(pressed) if pressed else "-"
+
+
+def readPcapng(path):
+    """Read all packets of a pcapng or pcap file: list of (time in s, link type, data)"""
+    with open(path, "rb") as f:
+        content = f.read()
+    packets = []
+    magic = struct.unpack_from("<I", content, 0)[0]
+    if magic in (0xA1B2C3D4, 0xA1B23C4D):  # classic pcap, little endian
+        resolution = 1e-6 if magic == 0xA1B2C3D4 else 1e-9
+        linktype = struct.unpack_from("<I", content, 20)[0]
+        offset = 24
+        while offset + 16 <= len(content):
+            seconds, fraction, captured, _ = struct.unpack_from("<IIII", content, offset)
+            packets.append((seconds + fraction * resolution, linktype, content[offset + 16:offset + 16 + captured]))
+            offset += 16 + captured
+        return packets
+
+    interfaces = []  # (link type, resolution of the timestamps) per interface description block
+    offset = 0
+    while offset + 12 <= len(content):
+        blockType, blockLength = struct.unpack_from("<II", content, offset)
+        if blockLength < 12:
+            break
+        body = content[offset + 8:offset + blockLength - 4]
+        if blockType == 0x00000001:  # interface description block
+            linktype = struct.unpack_from("<H", body, 0)[0]
+            interfaces.append([linktype, 1e-6])
+            option = 8
+            while option + 4 <= len(body):
+                code, length = struct.unpack_from("<HH", body, option)
+                if code == 0:
+                    break
+                if code == 9 and length >= 1:  # if_tsresol
+                    value = body[option + 4]
+                    interfaces[-1][1] = 2.0 ** -(value & 0x7F) if value & 0x80 else 10.0 ** -value
+                option += 4 + ((length + 3) & ~3)
+        elif blockType == 0x00000006:  # enhanced packet block
+            interface, high, low, captured, _ = struct.unpack_from("<IIIII", body, 0)
+            linktype, resolution = interfaces[interface]
+            packets.append((((high << 32) | low) * resolution, linktype, body[20:20 + captured]))
+        offset += blockLength
+    return packets
+
+
+def readCapture(path):
+    """Read the HID reports of a USB capture: list of Report"""
+    reports = []
+    for timestamp, linktype, packet in readPcapng(path):
+        if linktype == LINKTYPE_USBPCAP:
+            report = _fromUsbPcap(timestamp, packet)
+        elif linktype in (LINKTYPE_USB_LINUX, LINKTYPE_USB_LINUX_MMAPPED):
+            report = _fromUsbmon(timestamp, packet, 64 if linktype == LINKTYPE_USB_LINUX_MMAPPED else 48)
+        else:
+            raise IOError(f"{path}: link type {linktype} is no USB capture")
+        if report is not None:
+            reports.append(report)
+    return reports
+
+
+def _setReport(timestamp, setup, data, device):
+    """A SET_REPORT request in a control transfer, None for all other requests"""
+    requestType, request, valueLow, valueHigh = struct.unpack_from("<BBBB", setup, 0)
+    if requestType != 0x21 or request != HID_SET_REPORT:
+        return None
+    # the data stage usually starts with the report id, but only if the report has one
+    if not data or data[0] != valueLow:
+        data = bytes([valueLow]) + bytes(data)
+    return Report(timestamp, "out", "SET_REPORT " + REPORT_TYPES.get(valueHigh, str(valueHigh)), data, device)
+
+
+def _fromUsbPcap(timestamp, packet):
+    # USBPCAP_BUFFER_PACKET_HEADER: control transfers have one more byte for the stage
+    headerLength, _, _, _, info, bus, device, endpoint, transfer, _ = struct.unpack_from("<HQIHBHHBBI", packet, 0)
+    data = packet[headerLength:]
+    address = f"{bus}.{device}"
+    completion = info & 0x01  # 1: from the device to the host (completion of the request)
+    if transfer == TRANSFER_INTERRUPT and data:
+        if endpoint & 0x80 and completion:
+            return Report(timestamp, "in", "interrupt", data, address)
+        if not endpoint & 0x80 and not completion:
+            return Report(timestamp, "out", "interrupt", data, address)
+    if transfer == TRANSFER_CONTROL and packet[27] == 0 and len(data) >= 8:  # setup stage
+        return _setReport(timestamp, data[:8], data[8:], address)
+    return None
+
+
+def _fromUsbmon(timestamp, packet, headerLength):
+    # struct usbmon_packet of linux/Documentation/usb/usbmon.rst
+    eventType, transfer, endpoint, device, bus, setupFlag = struct.unpack_from("<cBBBHc", packet, 8)
+    seconds, microseconds = struct.unpack_from("<qi", packet, 16)
+    timestamp = seconds + microseconds * 1e-6
+    setup = packet[40:48]
+    data = packet[headerLength:]
+    address = f"{bus}.{device}"
+    if transfer == TRANSFER_INTERRUPT and data:
+        if endpoint & 0x80 and eventType == b"C":
+            return Report(timestamp, "in", "interrupt", data, address)
+        if not endpoint & 0x80 and eventType == b"S":
+            return Report(timestamp, "out", "interrupt", data, address)
+    if transfer == TRANSFER_CONTROL and eventType == b"S" and setupFlag == b"\x00":
+        return _setReport(timestamp, setup, data, address)
+    return None
+
+
+def readDescriptors(path):
+    """Read the descriptors, which the host requested with GET_DESCRIPTOR in a capture:
+    {(descriptor type, index): data}, the last answer of every request is kept"""
+    requests = {}  # descriptor of the pending requests per id of the transfer
+    descriptors = {}
+    for _, linktype, packet in readPcapng(path):
+        if linktype == LINKTYPE_USBPCAP:
+            headerLength, transferId, _, _, info, _, _, _, transfer, _ = struct.unpack_from("<HQIHBHHBBI", packet, 0)
+            if transfer != TRANSFER_CONTROL:
+                continue
+            data = packet[headerLength:]
+            if packet[27] == 0 and not info & 0x01 and len(data) >= 8:  # setup stage
+                setup = data[:8]
+            elif info & 0x01 and data:
+                setup = None
+            else:
+                continue
+        elif linktype in (LINKTYPE_USB_LINUX, LINKTYPE_USB_LINUX_MMAPPED):
+            transferId = struct.unpack_from("<Q", packet, 0)[0]
+            eventType, transfer, _, _, _, setupFlag = struct.unpack_from("<cBBBHc", packet, 8)
+            if transfer != TRANSFER_CONTROL:
+                continue
+            data = packet[64 if linktype == LINKTYPE_USB_LINUX_MMAPPED else 48:]
+            if eventType == b"S" and setupFlag == b"\x00":
+                setup = packet[40:48]
+            elif eventType == b"C" and data:
+                setup = None
+            else:
+                continue
+        else:
+            raise IOError(f"{path}: link type {linktype} is no USB capture")
+        if setup is not None:
+            requestType, request, index, descriptorType = struct.unpack_from("<BBBB", setup, 0)
+            if requestType & 0x80 and request == GET_DESCRIPTOR:
+                requests[transferId] = (descriptorType, index)
+            else:
+                requests.pop(transferId, None)
+        elif transferId in requests:
+            descriptors[requests.pop(transferId)] = bytes(data)
+    return descriptors
+
+
+def endpoints(configuration):
+    """The endpoint descriptors in a configuration descriptor: {address: (attributes, max packet size, interval)}"""
+    result = {}
+    offset = 0
+    while offset + 2 <= len(configuration) and configuration[offset] > 0:
+        length, descriptorType = configuration[offset], configuration[offset + 1]
+        if descriptorType == DESCRIPTOR_ENDPOINT and length >= 7:
+            address, attributes, packetSize, interval = struct.unpack_from("<BBHB", configuration, offset + 2)
+            result[address] = (attributes, packetSize, interval)
+        offset += length
+    return result
+
+
+def reportLayout(descriptor):
+    """The reports of a HID report descriptor: {(type, report id): length in bytes including the report id},
+    type is 'input', 'output' or 'feature'"""
+    layout = {}
+    reportId, reportSize, reportCount = 0, 0, 0
+    offset = 0
+    while offset < len(descriptor):
+        prefix = descriptor[offset]
+        if prefix == 0xFE:  # long item
+            offset += 3 + descriptor[offset + 1]
+            continue
+        size = (0, 1, 2, 4)[prefix & 0x03]
+        value = int.from_bytes(descriptor[offset + 1:offset + 1 + size], "little")
+        tag = prefix & 0xFC
+        if tag == 0x84:
+            reportId = value
+        elif tag == 0x74:
+            reportSize = value
+        elif tag == 0x94:
+            reportCount = value
+        elif tag in (0x80, 0x90, 0xB0):  # input, output, feature
+            kind = {0x80: "input", 0x90: "output", 0xB0: "feature"}[tag]
+            layout[(kind, reportId)] = layout.get((kind, reportId), 0) + reportSize * reportCount
+        offset += 1 + size
+    # the bits are padded to bytes, the report id is the first byte
+    return {key: (bits + 7) // 8 + (1 if key[1] else 0) for key, bits in layout.items()}
+
+
+def readSerialLog(path):
+    """Read the reports, which the firmware printed in debug mode 72: list of Report"""
+    reports = []
+    with open(path, errors="ignore") as f:
+        for line in f:
+            fields = line.strip().split()
+            if len(fields) < 3 or fields[0] != "R":
+                continue
+            try:
+                micros = int(fields[1])
+                data = bytes(int(v, 16) for v in fields[2:])
+            except ValueError:
+                continue  # e.g. a line, which was cut by the serial interface
+            reports.append(Report(micros * 1e-6, "in", "interrupt", data, "serial"))
+    # micros() overflows after 71 minutes
+    for previous, report in zip(reports, reports[1:]):
+        while report.time < previous.time:
+            report.time += 2 ** 32 * 1e-6
+    return reports
+
+
+def readSource(path, device=None, allDevices=False):
+    """Read the reports of a capture or a serial log, only of one USB device"""
+    if not path.endswith((".pcapng", ".pcap")):
+        return readSerialLog(path)
+    reports = readCapture(path)
+    if allDevices or not reports:
+        return reports
+    if device is None:
+        counts = {}
+        for report in reports:
+            counts[report.device] = counts.get(report.device, 0) + 1
+        device = max(counts, key=counts.get)
+    return [r for r in reports if r.device == device]
+
+
+def streams(reports):
+    """Sort the reports into streams per (direction, transfer, report id)"""
+    result = {}
+    for report in reports:
+        result.setdefault((report.direction, report.transfer, report.id), []).append(report)
+    return result
+
+
+def cadence(reports):
+    """Statistics of the intervals between the reports of one stream in ms:
+    (count, lengths, mean, min, max, histogram of the intervals rounded to ms)"""
+    intervals = [(b.time - a.time) * 1000 for a, b in zip(reports, reports[1:])]
+    lengths = sorted(set(len(r.data) for r in reports))
+    if not intervals:
+        return len(reports), lengths, None, None, None, {}
+    histogram = {}
+    for interval in intervals:
+        histogram[round(interval)] = histogram.get(round(interval), 0) + 1
+    return len(reports), lengths, sum(intervals) / len(intervals), min(intervals), max(intervals), histogram
+
+
+def printCadence(reports):
+    for key, stream in sorted(streams(reports).items(), key=lambda item: str(item[0])):
+        count, lengths, mean, minimum, maximum, histogram = cadence(stream)
+        direction, transfer, reportId = key
+        print(f"{direction:3} {transfer:19} {stream[0].name():10} count {count:6}  length {lengths}", end="")
+        if mean is None:
+            print()
+            continue
+        print(f"  interval [ms] mean {mean:7.2f} min {minimum:7.2f} max {maximum:8.2f}")
+        common = sorted(histogram.items(), key=lambda item: -item[1])[:5]
+        print("    most common intervals [ms]: " + ", ".join(f"{ms}: {n}x" for ms, n in common))
+
+
+def compare(reference, test, exact):
+    """Compare two report streams, return the number of differences"""
+    differences = 0
+    referenceStreams = streams(r for r in reference if r.direction == "in")
+    testStreams = streams(r for r in test if r.direction == "in")
+    for key in sorted(set(referenceStreams) | set(testStreams), key=str):
+        name = REPORT_NAMES.get(key[2], f"report {key[2]}")
+        if key not in testStreams:
+            print(f"{name}: only in the reference")
+            differences += 1
+            continue
+        if key not in referenceStreams:
+            print(f"{name}: only in the test")
+            differences += 1
+            continue
+        refCount, refLengths, refMean, _, _, _ = cadence(referenceStreams[key])
+        testCount, testLengths, testMean, _, _, _ = cadence(testStreams[key])
+        if refLengths != testLengths:
+            print(f"{name}: length {refLengths} in the reference, {testLengths} in the test")
+            differences += 1
+        if refMean is not None and testMean is not None:
+            print(f"{name}: mean interval {refMean:.2f} ms in the reference, {testMean:.2f} ms in the test")
+    if exact:
+        refData = [r.data for r in reference if r.direction == "in"]
+        testData = [r.data for r in test if r.direction == "in"]
+        for i, (a, b) in enumerate(zip(refData, testData)):
+            if a != b:
+                print(f"input report {i} differs: {a.hex(' ')} / {b.hex(' ')}")
+                differences += 1
+                break
+        if len(refData) != len(testData):
+            print(f"{len(refData)} input reports in the reference, {len(testData)} in the test")
+            differences += 1
+    return differences
+
+
+def record(port, path, seconds):
+    """Record the reports of the firmware via debug mode 72 into a file"""
+    import serial
+    with serial.Serial(port, baudrate=115200, timeout=0.5) as ser, open(path, "w") as f:
+        ser.reset_input_buffer()
+        ser.write(b"72\r\n")
+        end = time.time() + seconds
+        count = 0
+        while time.time() < end:
+            line = ser.readline().decode("utf-8", errors="ignore").strip()
+            if line.startswith("R "):
+                f.write(line + "\n")
+                count += 1
+        ser.write(b"q\r\n")  # leave the debug mode
+    print(f"{count} reports written to {path}")
+
+
+def main():
+    parser = argparse.ArgumentParser(description="Decode and compare the HID reports of USB captures and the firmware")
+    parser.add_argument("command", choices=["decode", "cadence", "compare", "record"])
+    parser.add_argument("source", help="capture (.pcapng, .pcap), serial log of debug mode 72 or serial port (record)")
+    parser.add_argument("other", nargs="?", help="compare: the source to test, record: the file to write")
+    parser.add_argument("--device", help="USB device in the capture, e.g. 1.3 (bus.address)")
+    parser.add_argument("--all-devices", action="store_true", help="keep the reports of all devices in the capture")
+    parser.add_argument("--exact", action="store_true", help="compare: also compare the data of the input reports")
+    parser.add_argument("--seconds", type=float, default=10, help="record: duration")
+    args = parser.parse_args()
+
+    if args.command == "record":
+        if args.other is None:
+            parser.error("record needs a file to write")
+        record(args.source, args.other, args.seconds)
+        return 0
+
+    reports = readSource(args.source, args.device, args.all_devices)
+    if args.command == "decode":
+        start = reports[0].time if reports else 0
+        for report in reports:
+            print(f"{report.time - start:10.6f} {report.device:8} {report.direction:3} {report.transfer:19} "
+                  f"{report.name():10} {report.decode()}")
+        return 0
+    if args.command == "cadence":
+        printCadence(reports)
+        return 0
+
+    if args.other is None:
+        parser.error("compare needs a second source")
+    differences = compare(reports, readSource(args.other, args.device, args.all_devices), args.exact)
+    print(f"{differences} differences")
+    return 1 if differences else 0
+
+
+if __name__ == '__main__':
+    sys.exit(main())
@@ -1,8 +1,24 @@
 # This script sets the correct names and hardware IDs for Spacemouse emulation to work.
 # From https://stackoverflow.com/a/76049354.
 
+import os
+import re
+
 Import("env")
 board_config = env.BoardConfig()
-board_config.update("build.hwids", [["0x256f", "0xc631"]])
-board_config.update("build.usb_product", "SpaceMouse Pro Wireless (cabled)")
+
+# With ADV_HID_SPACENAV in config.h, a SpaceNavigator is emulated instead of a SpaceMouse Pro.
+# The drivers choose the report layout by the hardware IDs, so they have to match the emulation.
+configFile = os.path.join(env.subst("$PROJECT_SRC_DIR"), "config.h")
+spaceNav = False
+if os.path.isfile(configFile):
+    with open(configFile) as f:
+        spaceNav = re.search(r"^\s*#define\s+ADV_HID_SPACENAV\b", f.read(), re.MULTILINE) is not None
+
+if spaceNav:
+    board_config.update("build.hwids", [["0x046d", "0xc626"]])
+    board_config.update("build.usb_product", "SpaceNavigator")
+else:
+    board_config.update("build.hwids", [["0x256f", "0xc631"]])
+    board_config.update("build.usb_product", "SpaceMouse Pro Wireless (cabled)")
 board_config.update("vendor", "3Dconnexion")
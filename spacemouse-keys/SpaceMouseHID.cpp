@@ -11,6 +11,7 @@ https://forum.arduino.cc/t/solved-unable-to-receive-hid-reports-from-computer-us
 #include <Arduino.h>
 #include "config.h"
 #include "SpaceMouseHID.h"
+#include <util/atomic.h>
 
 SpaceMouseHID_::SpaceMouseHID_() : PluggableUSBModule(2, 1, endpointTypes) {
   endpointTypes[0] = EP_TYPE_INTERRUPT_IN;
@@ -24,17 +25,52 @@ SpaceMouseHID_::SpaceMouseHID_() : PluggableUSBModule(2, 1, endpointTypes) {
   PluggableUSB().plug(this);
   nextState = ST_INIT; // init state machine with init state
   ledState = false;
+  calibrateRequested = false;
+  params = NULL;
+}
+
+/// @brief Take the report rate and endpoint interval from the parameters. They may be changed at
+/// runtime, the endpoint interval is only read by the host during the enumeration.
+/// @param par parameters with HID_RATE and HID_EPINT
+void SpaceMouseHID_::begin(ParamData &par) {
+  params = &par;
+}
+
+// round a time in ms down to 1, 2, 4, 8 or 16
+static uint8_t validInterval(int16_t ms) {
+  uint8_t valid = 1;
+  while (valid < 16 && (valid << 1) <= ms) {
+    valid <<= 1;
+  }
+  return valid;
+}
+
+/// @brief Get the time between two HID reports
+/// @return rate in ms: 1, 2, 4, 8 or 16
+uint8_t SpaceMouseHID_::getReportRate() {
+  return validInterval(params != NULL ? params->values->hidRate : HID_RATE);
+}
+
+/// @brief Get the polling interval of the endpoints for the descriptor
+/// @return interval in ms: 1, 2, 4, 8, 16 or 0 as in former versions
+uint8_t SpaceMouseHID_::getEndpointInterval() {
+  int16_t interval = (params != NULL) ? params->values->hidEpInterval : HID_EPINT;
+  if (interval <= 0) {
+    return 0;
+  }
+  return validInterval(interval);
 }
 
 int SpaceMouseHID_::getInterface(uint8_t *interfaceNumber) {
   interfaceNumber[0] += 1;
+  uint8_t interval = getEndpointInterval();
   SpaceMouseHIDDescriptor interfaceDescriptor = {
       D_INTERFACE(USBControllerInterface, 2, USB_DEVICE_CLASS_HUMAN_INTERFACE, 0, 0),
       SPACEMOUSE_D_HIDREPORT(sizeof(SpaceMouseReportDescriptor)),
       D_ENDPOINT(USB_ENDPOINT_IN(USBControllerEndpointIn), USB_ENDPOINT_TYPE_INTERRUPT, USB_EP_SIZE,
-                 0),
+                 interval),
       D_ENDPOINT(USB_ENDPOINT_OUT(USBControllerEndpointOut), USB_ENDPOINT_TYPE_INTERRUPT,
-                 USB_EP_SIZE, 0),
+                 USB_EP_SIZE, interval),
   };
   return USB_SendControl(0, &interfaceDescriptor, sizeof(interfaceDescriptor));
 }
@@ -71,6 +107,11 @@ bool SpaceMouseHID_::setup(USBSetup &setup) {
 
   if (requestType == REQUEST_DEVICETOHOST_CLASS_INTERFACE) {
     if (request == HID_GET_REPORT) {
+#ifdef ADV_HID_PARAMS
+      if (setup.wValueH == HID_REPORT_TYPE_FEATURE && setup.wValueL == HIDPARAMREPORT_ID) {
+        return sendParamReport();
+      }
+#endif
       // TODO: HID_GetReport();
       return true;
     }
@@ -90,11 +131,22 @@ bool SpaceMouseHID_::setup(USBSetup &setup) {
       return true;
     }
     if (request == HID_SET_REPORT) {
+#ifdef ADV_HID_PARAMS
+      if (setup.wValueH == HID_REPORT_TYPE_FEATURE && setup.wValueL == HIDPARAMREPORT_ID) {
+        return receiveParamReport(setup.wLength);
+      }
+#endif
       // If you press "Calibrate" in the windows driver of a _SpaceNavigator_ the following setup
       // request is sent: wValue: 0x0307 wIndex: 0 (0x0000) wLength: 2 Data Fragment: 0700
-      // Unfortunately, we are simulating a _SpaceMouse Pro Wireless (cabled)_, because it has more
-      // than two buttons With this SM pro, the windows driver is NOT sending this status report and
-      // their is no point in waiting for it...
+      // With the _SpaceMouse Pro Wireless (cabled)_, the windows driver is NOT sending this report,
+      // but with ADV_HID_SPACENAV it does. Short reports are dispatched like those from the OUT
+      // endpoint, the data stage starts with the report id.
+      if (setup.wLength > HIDOUTREPORT_MAXLEN) {
+        return false; // no handler for such a long report: stall the request
+      }
+      uint8_t report[HIDOUTREPORT_MAXLEN];
+      USB_RecvControl(report, setup.wLength);
+      dispatchOutputReport(report, setup.wLength);
       return true;
     }
   }
@@ -102,25 +154,191 @@ bool SpaceMouseHID_::setup(USBSetup &setup) {
   return false;
 }
 
+#ifdef ADV_HID_PARAMS
+// the first packet of a written parameter report must contain the header and some parameters
+static_assert(1 + HIDPARAMREPORT_LEN > USB_EP_SIZE, "ParamStorage is too small for the parameter report");
+
+/// @brief Answer GET_REPORT for the parameter report: report id, magic number, command (0) and the
+/// whole ParamStorage. The control transfer is split into packets by the USB core.
+/// @return true, if the request was handled
+bool SpaceMouseHID_::sendParamReport() {
+  if (params == NULL) {
+    return false;
+  }
+  long magicNumber = MAGIC_NUMBER;
+  uint8_t header[6];
+  header[0] = HIDPARAMREPORT_ID;
+  memcpy(&header[1], &magicNumber, 4);
+  header[5] = 0;
+  USB_SendControl(0, header, sizeof(header));
+  USB_SendControl(0, params->values, sizeof(ParamStorage));
+  return true;
+}
+
+/// @brief Receive SET_REPORT for the parameter report. The report id and the magic number in the
+/// first packet are checked, before the parameters are received. They are received into a buffer
+/// and taken by takeParamReport() in loop(), which may just be reading the parameters.
+/// @param length length of the data stage of the request
+/// @return true, if the parameters were taken
+bool SpaceMouseHID_::receiveParamReport(uint16_t length) {
+  if (params == NULL || length != 1 + HIDPARAMREPORT_LEN) {
+    return false;
+  }
+  // receive the first packet completely, USB_RecvControl() releases every packet after reading it
+  uint8_t packet[USB_EP_SIZE];
+  USB_RecvControl(packet, USB_EP_SIZE);
+  long magicNumber;
+  memcpy(&magicNumber, &packet[1], 4);
+  if (packet[0] != HIDPARAMREPORT_ID || magicNumber != MAGIC_NUMBER) {
+    return false; // another layout of ParamStorage: stall the request
+  }
+  // the rest of the parameters is received into the buffer. A report, which hasn't been taken by
+  // loop() yet, is replaced by the newer one.
+  uint8_t *storage = (uint8_t *)&receivedParams;
+  memcpy(storage, &packet[6], USB_EP_SIZE - 6);
+  USB_RecvControl(storage + USB_EP_SIZE - 6, sizeof(ParamStorage) - (USB_EP_SIZE - 6));
+  receivedCommand = packet[5];
+  paramsReceived = true;
+  return true;
+}
+#endif
+
+/// @brief Take the parameters of a received parameter report (ADV_HID_PARAMS). Call this in loop(),
+/// the EEPROM is too slow to be written in the USB interrupt, so saving is requested by
+/// takeSaveRequest().
+void SpaceMouseHID_::takeParamReport() {
+#ifdef ADV_HID_PARAMS
+  if (!paramsReceived) {
+    return;
+  }
+  // copy without interruption, the USB interrupt might receive the next report into the buffer
+  noInterrupts();
+  memcpy(params->values, &receivedParams, sizeof(ParamStorage));
+  uint8_t command = receivedCommand;
+  paramsReceived = false;
+  interrupts();
+
+  parametersChanged(*params);
+  if (command & HIDPARAM_SAVE) {
+    saveRequested = true;
+  }
+#endif
+}
+
+/// @brief Check and clear, if the host requested to save the parameters via the parameter report
+/// @return true, if the parameters shall be saved to the EEPROM now
+bool SpaceMouseHID_::takeSaveRequest() {
+#ifdef ADV_HID_PARAMS
+  if (saveRequested) {
+    saveRequested = false;
+    return true;
+  }
+#endif
+  return false;
+}
+
+/// @brief Check and clear, if the host requested a calibration, e.g. "Calibrate" in the driver
+/// @return true, if the joystick shall be zeroed now
+bool SpaceMouseHID_::takeCalibrateRequest() {
+  if (calibrateRequested) {
+    calibrateRequested = false;
+    return true;
+  }
+  return false;
+}
+
+// Handlers of the output reports from the host. Add new (vendor) reports here and increase
+// HIDOUTREPORT_HANDLERS. The handlers are called from loop() and from the USB interrupt (SET_REPORT),
+// so they must be short and only set some state.
+const SpaceMouseHID_::OutputReportEntry SpaceMouseHID_::outputReports[HIDOUTREPORT_HANDLERS] = {
+    {HIDLEDREPORT_ID, &SpaceMouseHID_::handleLEDReport},
+    {HIDCALIBRATEREPORT_ID, &SpaceMouseHID_::handleCalibrateReport},
+};
+
+/// @brief Count an output report and call the handler of its report id
+/// @param report the report, starting with the report id
+/// @param len length of the report including the report id
+void SpaceMouseHID_::dispatchOutputReport(const uint8_t *report, uint8_t len) {
+  if (len == 0) {
+    return;
+  }
+  uint8_t i = 0;
+  while (i < HIDOUTREPORT_HANDLERS && outputReports[i].id != report[0]) {
+    i++;
+  }
+  // called from loop() and from the USB interrupt: increment without interruption
+  ATOMIC_BLOCK(ATOMIC_RESTORESTATE) {
+    if (outputReportCount[i] < 0xFFFF) {
+      outputReportCount[i]++; // the last counter is for unknown report ids
+    }
+  }
+  if (i < HIDOUTREPORT_HANDLERS) {
+    (this->*outputReports[i].handler)(&report[1], len - 1);
+  }
+}
+
+// Report 4: the first bit switches the LED
+void SpaceMouseHID_::handleLEDReport(const uint8_t *data, uint8_t len) {
+  ledState = (len >= 1 && data[0] == 1); // if 1, led on!
+}
+
+// Report 7: the SpaceNavigator driver requests a calibration, the zeroing is started by loop()
+void SpaceMouseHID_::handleCalibrateReport(const uint8_t *data, uint8_t len) {
+  calibrateRequested = true;
+}
+
 int SpaceMouseHID_::write(const uint8_t *buffer, size_t size) {
   return USB_Send(USBControllerTX, buffer, size);
 }
 
-/// @brief Send a HID Report
+/// @brief Send a HID Report without blocking the loop. The report id and the data are sent in one
+/// transfer, but only if the endpoint has space for it. Otherwise the host hasn't taken the previous
+/// report yet and the caller shall try again in the next loop with the newest sample (coalescing).
 /// @param id Report Id of the data to be sent
 /// @param data Pointer to the data array
-/// @param len  Length of the data
-/// @return Length of data sent (including 1 byte for report id)
+/// @param len  Length of the data, max. HIDTRANSREPORT_LEN
+/// @return Length of data sent (including 1 byte for report id), 0 if the endpoint is busy or -1 if
+/// the transfer failed
 int SpaceMouseHID_::SendReport(uint8_t id, const void *data, int len) {
-  auto ret = USB_Send(USBControllerTX, &id, 1);
-  if (ret < 0)
-    return ret;
-
-  auto ret2 = USB_Send(USBControllerTX | TRANSFER_RELEASE, data, len);
-  if (ret2 < 0)
-    return ret2;
+  uint8_t report[1 + HIDTRANSREPORT_LEN];
+
+  if (USB_SendSpace(USBControllerTX) < len + 1) {
+    // the caller tries again in every loop: count one superseded report per HID_RATE
+    unsigned long now = millis();
+    if (!coalescing || now - lastCoalesced >= getReportRate()) {
+      reportsCoalesced++;
+      lastCoalesced = now;
+      coalescing = true;
+    }
+    return 0;
+  }
+  coalescing = false;
+  report[0] = id;
+  memcpy(&report[1], data, len);
+  int ret = USB_Send(USBControllerTX | TRANSFER_RELEASE, report, len + 1);
+  if (ret < len + 1) {
+    reportsDropped++;
+    return -1;
+  }
+  reportsSent++;
+  if (printReports) {
+    printReport(report, len + 1);
+  }
+  return ret;
+}
 
-  return ret + ret2;
+/// @brief Print a sent report for debug mode 72 as "R <time in us> <id> <data>" in hex, e.g.
+/// "R 1234567 01 0A 00 ...". progModePy/usbCapture.py reads these lines like a USB capture.
+/// @param report the report, starting with the report id
+/// @param len length of the report including the report id
+void SpaceMouseHID_::printReport(const uint8_t *report, int len) {
+  Serial.print(F("R "));
+  Serial.print(micros());
+  for (int i = 0; i < len; i++) {
+    Serial.print(report[i] < 0x10 ? F(" 0") : F(" "));
+    Serial.print(report[i], HEX);
+  }
+  Serial.println();
 }
 
 /// @brief Reads a single byte from the interface, if available
@@ -136,38 +354,30 @@ int SpaceMouseHID_::readSingleByte() {
 /// @brief Try to read some reports and print them
 /// @return  Returns nothing
 void SpaceMouseHID_::printAllReports() {
-  uint8_t numBytes = USB_Available(USBControllerRX);
-
-  if (numBytes >= 2) {
-    uint8_t data[2] = {0};
-    USB_Recv(USBControllerRX, data, numBytes);
-    for (int i = 0; i < numBytes; i++) {
-      Serial.print(data[i], HEX);
+  uint8_t numBytes;
+  while ((numBytes = USB_Available(USBControllerRX)) > 0) {
+    for (uint8_t i = 0; i < numBytes; i++) {
+      Serial.print(USB_Recv(USBControllerRX), HEX);
       Serial.print(", ");
     }
     Serial.println(" ");
-    // } else {
-    // Serial.print(".");
   }
 }
 
-/// @brief Check for LED hid reports (report Id: 4). This empties the RX buffer.
+/// @brief Read all output reports, which are pending in the OUT endpoint, and dispatch them by their
+/// report id, e.g. the LED report (report Id: 4). This empties the RX buffer.
 /// @return  Returns the led status
 bool SpaceMouseHID_::updateLEDState() {
-  uint8_t numBytes = USB_Available(USBControllerRX);
-
-  if (numBytes >= 2) {
-    uint8_t data[2] = {0};
-    USB_Recv(USBControllerRX, data, 2);
-    if (data[0] == 4) {   // LED report id: 4
-      if (data[1] == 1) { // if 1, led on!
-        ledState = true;
-        // Serial.println("led on!");
-      } else {
-        ledState = false;
-        // Serial.println("led off!");
-      }
+  uint8_t numBytes;
+  // every bank of the endpoint holds one report, it is released after its last byte is read
+  while ((numBytes = USB_Available(USBControllerRX)) > 0) {
+    uint8_t report[HIDOUTREPORT_MAXLEN];
+    uint8_t len = min(numBytes, (uint8_t)HIDOUTREPORT_MAXLEN);
+    USB_Recv(USBControllerRX, report, len);
+    for (uint8_t i = len; i < numBytes; i++) {
+      USB_Recv(USBControllerRX); // discard the rest of a report, which is too long for any handler
     }
+    dispatchOutputReport(report, len);
   }
   return ledState;
 }
@@ -178,18 +388,153 @@ bool SpaceMouseHID_::getLEDState() {
   return ledState;
 }
 
+/// @brief Get the number of the actual USB frame. The host starts a new frame every ms.
+/// @return frame number, 11 bit: it wraps every 2048 ms
+uint16_t SpaceMouseHID_::getFrameNumber() {
+#ifdef UDFNUM
+  return UDFNUM & 0x7FF;
+#else
+  // no USB frame counter (e.g. host test of the scheduler): one frame per ms, as on the bus
+  return millis() & 0x7FF;
+#endif
+}
+
+/// @brief Mark the start of a new sample: call this right before the sensors are read.
+/// It is used for the age of the reports. With ADV_HID_SOF, the slots of the reports are counted in
+/// USB frames: if the slot of the next report begins with the next frame, this waits for the start of
+/// that frame (at most 1 ms). So the sensors are read and the report is handed to the endpoint right
+/// at the beginning of its slot, independent of the phase of loop() to the frames of the host.
+void SpaceMouseHID_::startSample() {
+#ifdef ADV_HID_SOF
+  updateFrameTime();
+  if ((nextState == ST_SENDTRANS || nextState == ST_SENDKEYS) && !IsNewHidReportDue(frameTime) &&
+      IsNewHidReportDue(frameTime + 1)) {
+    uint16_t frame = lastFrameNumber;
+    unsigned long start = micros();
+    while (getFrameNumber() == frame && micros() - start < 1100) {
+      delayMicroseconds(4);
+    }
+    updateFrameTime();
+  }
+  sampleFrameTime = frameTime;
+#endif
+  sampleTime = micros();
+}
+
+#ifdef ADV_HID_SOF
+/// @brief Extend the 11 bit frame number to a continuous frame time
+void SpaceMouseHID_::updateFrameTime() {
+  uint16_t frame = getFrameNumber();
+  unsigned long ms = millis();
+  unsigned long elapsed = (frame - lastFrameNumber) & 0x7FF;
+  // if loop() was blocked for more than 2 s (e.g. by the serial menu), the frame number wrapped
+  // unnoticed: add the lost multiples of 2048 frames, as measured by millis()
+  long lost = (long)(ms - lastSampleMillis - elapsed) + 1024;
+  if (lost >= 2048) {
+    elapsed += (unsigned long)lost & ~0x7FFUL;
+  }
+  frameTime += elapsed;
+  lastFrameNumber = frame;
+  lastSampleMillis = ms;
+}
+#endif
+
+/// @brief Count the age of the sample in a report, which is sent right now
+/// @param sampled time from micros(), when the sample of the report was taken
+void SpaceMouseHID_::countReportAge(unsigned long sampled) {
+  unsigned long age = (micros() - sampled) / 250;
+  uint8_t bucket = 0;
+  while (age > 0 && bucket < HIDAGE_BUCKETS - 1) {
+    age >>= 1;
+    bucket++;
+  }
+  if (ageHistogram[bucket] < 0xFFFF) {
+    ageHistogram[bucket]++;
+  }
+}
+
+/// @brief Print the histogram of the age of the sent reports once a second and reset it
+/// The age is the time between reading the sensors and handing the report to the USB endpoint.
+void SpaceMouseHID_::printReportAge() {
+  static unsigned long lastPrint = 0;
+  if (millis() - lastPrint < 1000) {
+    return;
+  }
+  lastPrint = millis();
+  Serial.print(F("Report age [us]"));
+  uint16_t limit = 250;
+  for (uint8_t i = 0; i < HIDAGE_BUCKETS; i++) {
+    if (i < HIDAGE_BUCKETS - 1) {
+      Serial.print(F(" <"));
+      Serial.print(limit);
+      limit <<= 1;
+    } else {
+      Serial.print(F(" more"));
+    }
+    Serial.print(F(": "));
+    Serial.print(ageHistogram[i]);
+    ageHistogram[i] = 0;
+  }
+  Serial.println();
+  Serial.print(F("Reports sent: "));
+  Serial.print(reportsSent);
+  Serial.print(F(" coalesced: "));
+  Serial.print(reportsCoalesced);
+  Serial.print(F(" dropped: "));
+  Serial.print(reportsDropped);
+  Serial.print(F(" suppressed: "));
+  Serial.println(reportsSuppressed);
+  // the USB interrupt counts the output reports sent by SET_REPORT: copy them without interruption
+  uint16_t counts[HIDOUTREPORT_HANDLERS + 1];
+  noInterrupts();
+  for (uint8_t i = 0; i <= HIDOUTREPORT_HANDLERS; i++) {
+    counts[i] = outputReportCount[i];
+  }
+  interrupts();
+  Serial.print(F("Output reports"));
+  for (uint8_t i = 0; i <= HIDOUTREPORT_HANDLERS; i++) {
+    if (i < HIDOUTREPORT_HANDLERS) {
+      Serial.print(F(" id "));
+      Serial.print(outputReports[i].id);
+    } else {
+      Serial.print(F(" other"));
+    }
+    Serial.print(F(": "));
+    Serial.print(counts[i]);
+  }
+  Serial.println();
+}
+
 bool SpaceMouseHID_::send_command(int16_t rx, int16_t ry, int16_t rz, int16_t x, int16_t y,
                                   int16_t z, uint8_t *keys, int debug) {
+#ifdef ADV_HID_SOF
+  // the time base is the USB frame (1 ms) at the start of the sample
+  unsigned long now = sampleFrameTime;
+#else
   unsigned long now = millis();
+#endif
   bool hasSentNewData = false; // this value will be returned
+  printReports = (debug == 72);
 
 #if (NUMKEYS > 0)
   static uint8_t keyData[4];             // key data to be sent via HID
   static uint8_t prevKeyData[4];         // previous key data
+#ifdef KEYMAP
+  memcpy(keyData, keys, 4); // the bits are already sorted by evalKeyMap()
+#else
   prepareKeyBytes(keys, keyData, debug); // sort the bytes from keys into the bits in keyData
 #endif
+#ifdef ADV_HID_SPACENAV
+  // only the first two buttons are known by the SpaceNavigator
+  keyData[0] &= 0x03;
+  memset(&keyData[1], 0, 3);
+#endif
+  bool keysChanged = (memcmp(keyData, prevKeyData, 4) != 0);
+#else
+  bool keysChanged = false;
+#endif
 
-#ifdef ADV_HID_JIGGLE
+#if defined(ADV_HID_JIGGLE) && !defined(ADV_HID_DELTA)
   static bool toggleValue; // variable to track if values shall be jiggled or not
 #endif
 
@@ -198,15 +543,35 @@ bool SpaceMouseHID_::send_command(int16_t rx, int16_t ry, int16_t rz, int16_t x,
     // init the variables
     lastHIDsentRep = now;
     nextState = ST_START;
-#ifdef ADV_HID_JIGGLE
+#if defined(ADV_HID_JIGGLE) && !defined(ADV_HID_DELTA)
     toggleValue = false;
 #endif
     break;
 
-  case ST_START:
-    // Evaluate everytime, without waiting for 8ms
-    if (countTransZeros < 3 || countRotZeros < 3 ||
-        (x != 0 || y != 0 || z != 0 || rx != 0 || ry != 0 || rz != 0)) {
+  case ST_START: {
+    // Evaluate everytime, without waiting for HID_RATE
+    bool sendAxes = (countTransZeros < 3 || countRotZeros < 3 ||
+                     (x != 0 || y != 0 || z != 0 || rx != 0 || ry != 0 || rz != 0));
+#ifdef ADV_HID_DELTA
+    int16_t axes[6] = {x, y, z, rx, ry, rz};
+    if (sendAxes && axesUnchanged(axes) && (now - lastAxesSent < ADV_HID_DELTA)) {
+      // the host has these values already: don't send them again before the keep-alive is due
+      sendAxes = false;
+      static unsigned long lastSuppressed; // count one suppressed report per HID_RATE
+      if (now - lastSuppressed >= getReportRate()) {
+        reportsSuppressed++;
+        lastSuppressed = now;
+      }
+      // identical zeros count as sent zeros
+      if (x == 0 && y == 0 && z == 0 && countTransZeros < 3) {
+        countTransZeros++;
+      }
+      if (rx == 0 && ry == 0 && rz == 0 && countRotZeros < 3) {
+        countRotZeros++;
+      }
+    }
+#endif
+    if (sendAxes) {
       // if one of the values is not zero,
       // or not all zero data packages are sent (sent 3 of them)
       // start sending data
@@ -215,35 +580,86 @@ bool SpaceMouseHID_::send_command(int16_t rx, int16_t ry, int16_t rz, int16_t x,
 // if nothing is to be sent, check for keys. If no keys, don't change state
 #if (NUMKEYS > 0)
       // compare key data to previous key data
-      if (memcmp(keyData, prevKeyData, 4) != 0) {
+      if (keysChanged) {
+#ifdef ADV_HID_COMBINED
+        nextState = ST_SENDTRANS; // the keys are sent together with the axes
+#else
         nextState = ST_SENDKEYS;
+#endif
       }
 #endif
       if (nextState == ST_START && IsNewHidReportDue(now)) {
         // if we are not leaving the start state and
         // we are waiting here for more than the update rate,
         // keep the timestamp for the last sent package nearby
-        lastHIDsentRep = now - HIDUPDATERATE_MS;
+        lastHIDsentRep = now - getReportRate();
       }
     }
     break;
+  }
 
   case ST_SENDTRANS:
-    // send translation data, if the 8 ms from the last hid report have past
+    // send translation data, if HID_RATE ms from the last hid report have past
     if (IsNewHidReportDue(now)) {
-      uint8_t trans[12] = {(byte)(x & 0xFF),  (byte)(x >> 8),  (byte)(y & 0xFF),  (byte)(y >> 8),
-                           (byte)(z & 0xFF),  (byte)(z >> 8),  (byte)(rx & 0xFF), (byte)(rx >> 8),
-                           (byte)(ry & 0xFF), (byte)(ry >> 8), (byte)(rz & 0xFF), (byte)(rz >> 8)};
+      uint8_t trans[HIDTRANSREPORT_LEN] = {
+          (byte)(x & 0xFF),  (byte)(x >> 8),  (byte)(y & 0xFF),  (byte)(y >> 8),
+          (byte)(z & 0xFF),  (byte)(z >> 8),  (byte)(rx & 0xFF), (byte)(rx >> 8),
+          (byte)(ry & 0xFF), (byte)(ry >> 8), (byte)(rz & 0xFF), (byte)(rz >> 8)};
+#if defined(ADV_HID_COMBINED) && (NUMKEYS > 0)
+      // the keys follow the axes in the same report
+      memcpy(&trans[12], keyData, 4);
+#endif
 
-#ifdef ADV_HID_JIGGLE
+#if defined(ADV_HID_JIGGLE) && defined(ADV_HID_DELTA)
+      {
+        // only a keep-alive repeats the last values: flip the last bit of the non-zero values, so
+        // that the host sees a change. New values are sent as they are, so the next report after a
+        // keep-alive sends the real values again.
+        int16_t axes[6] = {x, y, z, rx, ry, rz};
+        bool keepAlive = axesUnchanged(axes);
+#if defined(ADV_HID_COMBINED) && (NUMKEYS > 0)
+        // a report for changed keys repeats the axes exactly as in the last report, without a motion
+        keepAlive = keepAlive && !keysChanged;
+#endif
+        if (keepAlive) {
+          for (uint8_t i = 0; i < 12; i += 2) {
+            if (trans[i] != 0 || trans[i + 1] != 0) {
+              trans[i] ^= 1;
+            }
+          }
+        }
+      }
+#elif defined(ADV_HID_JIGGLE)
       jiggleValues(trans, toggleValue); // jiggle the non-zero values, if toggleValue is true
 #endif
-      SendReport(1, trans, 12); // send new translational values
-#ifdef ADV_HID_JIGGLE
+#ifdef ADV_HID_SPACENAV
+      // send the translation now and the rotation of the same sample in the next USB frame
+      if (SendReport(1, trans, 6) <= 0) {
+        break; // not sent: try again in the next loop with a newer sample
+      }
+      memcpy(rotData, &trans[6], 6);
+      rotSampleTime = sampleTime;
+#else
+      if (SendReport(1, trans, HIDTRANSREPORT_LEN) <= 0) { // send new translational values
+        break; // not sent: try again in the next loop with a newer sample
+      }
+#endif
+      countReportAge(sampleTime);
+#if defined(ADV_HID_COMBINED) && (NUMKEYS > 0)
+      memcpy(prevKeyData, keyData, 4); // the keys were sent
+#endif
+#if defined(ADV_HID_JIGGLE) && !defined(ADV_HID_DELTA)
       // flip the toggle so the LSB alternates on next report
       toggleValue = !toggleValue;
 #endif
-      lastHIDsentRep += HIDUPDATERATE_MS;
+#ifdef ADV_HID_DELTA
+      // the axes as they were sent, also if they were jiggled
+      for (uint8_t i = 0; i < 6; i++) {
+        lastAxes[i] = (int16_t)(trans[2 * i] | (trans[2 * i + 1] << 8));
+      }
+      lastAxesSent = now;
+#endif
+      nextSlot(now);
       hasSentNewData = true; // return value
 
       // if only zeros where send, increment zero counter, otherwise reset it
@@ -257,27 +673,35 @@ bool SpaceMouseHID_::send_command(int16_t rx, int16_t ry, int16_t rz, int16_t x,
       } else {
         countRotZeros = 0;
       }
-// check if the next state should be keys
-#if (NUMKEYS > 0)
-      // compare key data to previous key data
-      if (memcmp(keyData, prevKeyData, 4) != 0) {
-        nextState = ST_SENDKEYS;
-      } else {
-        nextState = ST_START;
-      } // go back to start
+#ifdef ADV_HID_SPACENAV
+      nextState = ST_SENDROT; // the rotation of the same sample follows in report 2
 #else
-      // if no keys are used, go to start state after rotations
-      nextState = ST_START;
+      nextState = stateAfterAxes(keysChanged);
 #endif
     }
     break;
 
-#if (NUMKEYS > 0)
+#ifdef ADV_HID_SPACENAV
+  case ST_SENDROT:
+    // send the rotation right after the translation, without waiting for the next HID slot: as soon
+    // as the endpoint has a free bank, which is the case in the next USB frame at the latest
+    if (SendReport(2, rotData, 6) > 0) {
+      countReportAge(rotSampleTime);
+      hasSentNewData = true;
+      nextState = stateAfterAxes(keysChanged);
+    }
+    break;
+#endif
+
+#if (NUMKEYS > 0) && !defined(ADV_HID_COMBINED)
   case ST_SENDKEYS:
-    // report the keys, if the 8 ms since the last report have past
+    // report the keys, if HID_RATE ms since the last report have past
     if (IsNewHidReportDue(now)) {
-      SendReport(3, keyData, 4);
-      lastHIDsentRep += HIDUPDATERATE_MS;
+      if (SendReport(3, keyData, HIDKEYREPORT_LEN) <= 0) {
+        break; // not sent: try again in the next loop with the newest keys
+      }
+      countReportAge(sampleTime);
+      nextSlot(now);
       memcpy(prevKeyData, keyData, 4); // copy actual keyData to previous keyData
       hasSentNewData = true;           // return value
       nextState = ST_START;            // go back to start
@@ -294,11 +718,37 @@ bool SpaceMouseHID_::send_command(int16_t rx, int16_t ry, int16_t rz, int16_t x,
   return hasSentNewData;
 }
 
+// the axes were sent: send the keys next, if they changed and aren't part of report 1 anyway
+SpaceMouseHIDStates SpaceMouseHID_::stateAfterAxes(bool keysChanged) {
+#if (NUMKEYS > 0) && !defined(ADV_HID_COMBINED)
+  if (keysChanged) {
+    return ST_SENDKEYS;
+  }
+#endif
+  return ST_START; // no keys, unchanged keys or the keys were sent with the axes
+}
+
+// the report of this slot was sent: the next slot starts HID_RATE later, but not in the past, e.g.
+// after the host didn't take any reports for a while. Otherwise the missed slots were sent in a burst.
+void SpaceMouseHID_::nextSlot(unsigned long now) {
+  lastHIDsentRep += getReportRate();
+  if (IsNewHidReportDue(now)) {
+    lastHIDsentRep = now;
+  }
+}
+
+#ifdef ADV_HID_DELTA
+// check if the axes are the same as in the last report 1
+bool SpaceMouseHID_::axesUnchanged(const int16_t axes[6]) {
+  return memcmp(axes, lastAxes, sizeof(lastAxes)) == 0;
+}
+#endif
+
 // check if a new HID report shall be send
 bool SpaceMouseHID_::IsNewHidReportDue(unsigned long now) {
   // calculate the difference between now and the last time it was sent
   // such a difference calculation is safe with regard to integer overflow after 48 days
-  return (now - lastHIDsentRep >= HIDUPDATERATE_MS);
+  return (now - lastHIDsentRep >= getReportRate());
 }
 
 // function to add jiggle to the values, if they are not zero.
@@ -334,7 +784,7 @@ void SpaceMouseHID_::prepareKeyBytes(uint8_t *keys, uint8_t *keyData, int debug)
       // set the according bit in the data bytes
       // byte no.: bitNumber[i] / 8
       // bit no.:  bitNumber[i] modulo 8
-      keyData[(bitNumber[i] / 8)] = (1 << (bitNumber[i] % 8));
+      keyData[(bitNumber[i] / 8)] |= (1 << (bitNumber[i] % 8));
       if (debug == 8) {
         // debug the key board outputs
         Serial.print("bitnumber: ");
@@ -17,6 +17,7 @@ This code is based on https://forum.arduino.cc/t/solved-unable-to-receive-hid-re
 
 #include "PluggableUSB.h"
 #include "HID.h"
+#include "parameterMenu.h"
 
 #define SPACEMOUSE_D_HIDREPORT(length) \
     {                                  \
@@ -29,12 +30,80 @@ typedef struct
     EndpointDescriptor out;
 } SpaceMouseHIDDescriptor;
 
+// Report 8: vendor defined feature report to read and write all parameters at once, see ADV_HID_PARAMS
+#define HIDPARAMREPORT_ID  8
+// Length without the report id: magic number (4 bytes), command (1 byte) and the whole ParamStorage
+#define HIDPARAMREPORT_LEN (4 + 1 + sizeof(ParamStorage))
+// Bit in the command byte of a written parameter report: save the parameters to the EEPROM
+#define HIDPARAM_SAVE      1
+
+// Report 4: LED state, sent by the host to the OUT endpoint
+#define HIDLEDREPORT_ID       4
+// Report 7: "Calibrate" of the SpaceNavigator driver, sent by the host as SET_REPORT (feature)
+#define HIDCALIBRATEREPORT_ID 7
+// Longest output report (with report id), which is dispatched to a handler. Longer ones are discarded.
+#define HIDOUTREPORT_MAXLEN   8
+// Number of output reports with a handler, see outputReports[] in SpaceMouseHID.cpp
+#define HIDOUTREPORT_HANDLERS 2
+
 // The USB VID and PID for this emulated space mouse pro must be set in the boards.txt in arduino IDE or in set_hwids.py in platformIO.
 
 static const uint8_t SpaceMouseReportDescriptor[] PROGMEM = {
     0x05, 0x01,          // Usage Page (Generic Desktop)
     0x09, 0x08,          // Usage (Multi-Axis)
     0xA1, 0x01,          // Collection (Application)
+#ifdef ADV_HID_SPACENAV  // SpaceNavigator with split reports, see SpaceNavigator.md
+                         // Report 1: Translation
+    0xA1, 0x00,          //   Collection (Physical)
+    0x85, 0x01,          //     Report ID (1)
+    0x16, 0xA2, 0xFE,    //     Logical Minimum (-350)
+    0x26, 0x5E, 0x01,    //     Logical Maximum (350)
+    0x36, 0x88, 0xFA,    //     Physical Minimum (-1400)
+    0x46, 0x78, 0x05,    //     Physical Maximum (1400)
+    0x55, 0x0C,          //     Unit Exponent (-4)
+    0x65, 0x11,          //     Unit (System: SI Linear, Length: Centimeter)
+    0x09, 0x30,          //     Usage (X)
+    0x09, 0x31,          //     Usage (Y)
+    0x09, 0x32,          //     Usage (Z)
+    0x75, 0x10,          //     Report Size (16)
+    0x95, 0x03,          //     Report Count (3)
+#ifdef ADV_HID_REL
+    0x81, 0x06,          //     Input (Data,Var,Rel,No Wrap,Linear,Preferred State,No Null Position)
+#else
+    0x81, 0x02,          //     Input (variable,absolute)
+#endif
+    0xC0,                //   End Collection
+                         // Report 2: Rotation
+    0xA1, 0x00,          //   Collection (Physical)
+    0x85, 0x02,          //     Report ID (2)
+    0x09, 0x33,          //     Usage (Rx)
+    0x09, 0x34,          //     Usage (Ry)
+    0x09, 0x35,          //     Usage (Rz)
+    0x75, 0x10,          //     Report Size (16)
+    0x95, 0x03,          //     Report Count (3)
+#ifdef ADV_HID_REL
+    0x81, 0x06,          //     Input (Data,Var,Rel,No Wrap,Linear,Preferred State,No Null Position)
+#else
+    0x81, 0x02,          //     Input (variable,absolute)
+#endif
+    0xC0,                //   End Collection
+                         // Report 3: Keys, the SpaceNavigator has only two buttons
+    0xA1, 0x02,          //   Collection (Logical)
+    0x85, 0x03,          //     Report ID (3)
+    0x05, 0x09,          //     Usage Page (Button)
+    0x19, 0x01,          //     Usage Minimum (Button #1)
+    0x29, 0x02,          //     Usage Maximum (Button #2)
+    0x15, 0x00,          //     Logical Minimum (0)
+    0x25, 0x01,          //     Logical Maximum (1)
+    0x35, 0x00,          //     Physical Minimum (0)
+    0x45, 0x01,          //     Physical Maximum (1)
+    0x75, 0x01,          //     Report Size (1)
+    0x95, 0x02,          //     Report Count (2)
+    0x81, 0x02,          //     Input (variable,absolute)
+    0x95, 0x0E,          //     Report Count (14)
+    0x81, 0x03,          //     Input (Const,Var,Abs,No Wrap,Linear,Preferred State,No Null Position)
+    0xC0,                //   End Collection
+#else
                          // Report 1: Translation
     0xA1, 0x00,          //   Collection (Physical)
     0x85, 0x01,          //     Report ID (1)
@@ -57,6 +126,21 @@ static const uint8_t SpaceMouseReportDescriptor[] PROGMEM = {
 #else
     0x81, 0x02, // Input (variable,absolute)
 #endif
+#ifdef ADV_HID_COMBINED  // the keys are part of report 1, see Advanced HID settings in config_sample.h
+    0x05, 0x09,          //     Usage Page (Button)
+    0x19, 0x01,          //     Usage Minimum (Button #1)
+    0x29, 0x20,          //     Usage Maximum (Button #32)
+    0x15, 0x00,          //     Logical Minimum (0)
+    0x25, 0x01,          //     Logical Maximum (1)
+    0x35, 0x00,          //     Physical Minimum (0)
+    0x45, 0x00,          //     Physical Maximum (0 = same as logical)
+    0x55, 0x00,          //     Unit Exponent (0)
+    0x65, 0x00,          //     Unit (None)
+    0x75, 0x01,          //     Report Size (1)
+    0x95, 0x20,          //     Report Count (32)
+    0x81, 0x02,          //     Input (variable,absolute)
+    0xC0,                //   End Collection
+#else
     0xC0,                //   End Collection
                          // Report 3: Keys  
     0xa1, 0x00,          // Collection (Physical)
@@ -70,9 +154,11 @@ static const uint8_t SpaceMouseReportDescriptor[] PROGMEM = {
     0x29, 0x20,          //    Usage Maximum (Button #24, needs 32 bits)
     0x81, 0x02,          //    Input (variable,absolute)
     0xC0,                // End Collection
+#endif
+#endif // ADV_HID_SPACENAV
                          // Report 4: LEDs
     0xA1, 0x02,          //   Collection (Logical)
-    0x85, 0x04,          //     Report ID (4)
+    0x85, HIDLEDREPORT_ID, //   Report ID (4)
     0x05, 0x08,          //     Usage Page (LEDs)
     0x09, 0x4B,          //     Usage (Generic Indicator)
     0x15, 0x00,          //     Logical Minimum (0)
@@ -84,6 +170,32 @@ static const uint8_t SpaceMouseReportDescriptor[] PROGMEM = {
     0x75, 0x07,          //     Report Size (7)
     0x91, 0x03,          //     Output (Const,Var,Abs,No Wrap,Linear,Preferred State,No Null Position,Non-volatile)
     0xC0,                //   End Collection
+#ifdef ADV_HID_SPACENAV  // Report 7: Calibrate, the SpaceNavigator driver writes 0x00 to it
+    0x06, 0x00, 0xFF,    //   Usage Page (Vendor Defined 0xFF00)
+    0x09, 0x01,          //   Usage (0x01)
+    0xA1, 0x02,          //   Collection (Logical)
+    0x85, HIDCALIBRATEREPORT_ID, // Report ID (7)
+    0x09, 0x22,          //     Usage (0x22), as in the descriptor of the SpaceNavigator
+    0x15, 0x80,          //     Logical Minimum (-128)
+    0x25, 0x7F,          //     Logical Maximum (127)
+    0x75, 0x08,          //     Report Size (8)
+    0x95, 0x01,          //     Report Count (1)
+    0xB1, 0x02,          //     Feature (Data,Var,Abs,No Wrap,Linear,Preferred State,No Null Position,Non-volatile)
+    0xC0,                //   End Collection
+#endif
+#ifdef ADV_HID_PARAMS    // Report 8: Parameters, see Advanced HID settings in config_sample.h
+    0x06, 0x00, 0xFF,    //   Usage Page (Vendor Defined 0xFF00)
+    0x09, 0x01,          //   Usage (0x01)
+    0xA1, 0x02,          //   Collection (Logical)
+    0x85, HIDPARAMREPORT_ID, //   Report ID (8)
+    0x09, 0x02,          //     Usage (0x02)
+    0x15, 0x00,          //     Logical Minimum (0)
+    0x26, 0xFF, 0x00,    //     Logical Maximum (255)
+    0x75, 0x08,          //     Report Size (8)
+    0x96, lowByte(HIDPARAMREPORT_LEN), highByte(HIDPARAMREPORT_LEN), // Report Count (HIDPARAMREPORT_LEN)
+    0xB1, 0x02,          //     Feature (Data,Var,Abs,No Wrap,Linear,Preferred State,No Null Position,Non-volatile)
+    0xC0,                //   End Collection
+#endif
     0xC0                 // END_COLLECTION
 };
 
@@ -93,8 +205,22 @@ static const uint8_t SpaceMouseReportDescriptor[] PROGMEM = {
 #define USBControllerTX USBControllerEndpointIn
 #define USBControllerRX USBControllerEndpointOut
 
-// Send a HID report every 8 ms
-#define HIDUPDATERATE_MS 16
+// Number of buckets of the histogram of the report age (debug mode 71): <250 us, <500 us, ... <16 ms, more
+#define HIDAGE_BUCKETS 8
+
+// Length of report 1 without the report id: six axes with 16 bit
+#ifdef ADV_HID_COMBINED
+#define HIDTRANSREPORT_LEN 16 // and the 32 bits of the keys
+#else
+#define HIDTRANSREPORT_LEN 12
+#endif
+
+// Length of report 3 without the report id
+#ifdef ADV_HID_SPACENAV
+#define HIDKEYREPORT_LEN 2 // two buttons and padding
+#else
+#define HIDKEYREPORT_LEN 4 // 32 buttons
+#endif
 
 // State machine to track, which report to send next
 enum SpaceMouseHIDStates
@@ -102,7 +228,7 @@ enum SpaceMouseHIDStates
     ST_INIT,      // init variables
     ST_START,     // start to check if something is to be sent
     ST_SENDTRANS, // send translations
-    ST_SENDROT,   // send rotations
+    ST_SENDROT,   // send rotations (only ADV_HID_SPACENAV), right after the translations
     ST_SENDKEYS   // send keys
 };
 
@@ -110,6 +236,7 @@ class SpaceMouseHID_ : public PluggableUSBModule
 {
 public:
     SpaceMouseHID_();
+    void begin(ParamData &par);
     int write(const uint8_t *buffer, size_t size);
     int SendReport(uint8_t id, const void *data, int len);
     int readSingleByte();
@@ -117,9 +244,44 @@ public:
     bool updateLEDState();
     bool getLEDState();
     bool send_command(int16_t rx, int16_t ry, int16_t rz, int16_t x, int16_t y, int16_t z, uint8_t *keys, int debug);
+    void startSample();
+    uint16_t getFrameNumber();
+    void printReportAge();
+    void takeParamReport();
+    bool takeSaveRequest();
+    bool takeCalibrateRequest();
 
 private:
+    // Handler of an output report from the host, called with the data after the report id
+    typedef void (SpaceMouseHID_::*OutputReportHandler)(const uint8_t *data, uint8_t len);
+    struct OutputReportEntry
+    {
+        uint8_t id;
+        OutputReportHandler handler;
+    };
+    static const OutputReportEntry outputReports[HIDOUTREPORT_HANDLERS];
+    void dispatchOutputReport(const uint8_t *report, uint8_t len);
+    void handleLEDReport(const uint8_t *data, uint8_t len);
+    void handleCalibrateReport(const uint8_t *data, uint8_t len);
+
     bool IsNewHidReportDue(unsigned long now);
+    void nextSlot(unsigned long now);
+    SpaceMouseHIDStates stateAfterAxes(bool keysChanged);
+    uint8_t getReportRate();
+    uint8_t getEndpointInterval();
+#ifdef ADV_HID_PARAMS
+    bool sendParamReport();
+    bool receiveParamReport(uint16_t length);
+    ParamStorage receivedParams;  // parameters of the last received report, until taken by loop()
+    volatile uint8_t receivedCommand;
+    volatile bool paramsReceived;
+    bool saveRequested; // the parameters shall be saved to the EEPROM by loop()
+#endif
+
+    ParamData *params; // parameters with the HID timing, NULL until begin() is called
+    void countReportAge(unsigned long sampled);
+    void printReport(const uint8_t *report, int len);
+    bool printReports; // debug mode 72: print every sent report
     bool jiggleValues(uint8_t val[6], bool lastBit);
 
     SpaceMouseHIDStates nextState;
@@ -130,10 +292,40 @@ private:
 #endif
     uint8_t countTransZeros = 10; // count how many times, the zero data has been sent
     uint8_t countRotZeros = 10;
+#ifdef ADV_HID_DELTA
+    int16_t lastAxes[6];         // axes as sent in the last report 1: x, y, z, rx, ry, rz
+    unsigned long lastAxesSent;  // time of the last report 1, same time base as lastHIDsentRep
+    bool axesUnchanged(const int16_t axes[6]);
+#endif
+#ifdef ADV_HID_SPACENAV
+    uint8_t rotData[6]; // rotation of the motion sample, whose translation was just sent in report 1
+    unsigned long rotSampleTime; // time from micros(), when this sample was taken
+#endif
 
-    unsigned long lastHIDsentRep; // time from millis(), when the last HID report was sent
+    unsigned long lastHIDsentRep; // time from millis() or frame time (ADV_HID_SOF), when the last HID report was sent
+
+    // counters of the reports since the start, see SendReport() and debug mode 71
+    unsigned long reportsSent;      // handed to the endpoint
+    unsigned long reportsCoalesced; // not sent, because the host hadn't taken the previous report yet
+    unsigned long lastCoalesced;    // time from millis() of the last count of reportsCoalesced
+    bool coalescing;                // the last report wasn't sent, because the endpoint was busy
+    unsigned long reportsDropped;   // the transfer failed
+    unsigned long reportsSuppressed; // not sent, because the axes didn't change (ADV_HID_DELTA)
+
+    unsigned long sampleTime;                // time from micros(), when the sensors were read for this loop
+    uint16_t ageHistogram[HIDAGE_BUCKETS];   // number of reports per age bucket, see countReportAge()
+#ifdef ADV_HID_SOF
+    unsigned long sampleFrameTime; // frame time, when the sensors were read for this loop
+    unsigned long frameTime;       // number of USB frames (1 ms) since start, extended from 11 bits
+    uint16_t lastFrameNumber;      // frame number of the last update of frameTime
+    unsigned long lastSampleMillis; // time from millis() of the last update of frameTime
+    void updateFrameTime();
+#endif
 
     bool ledState;
+    volatile bool calibrateRequested; // the host requested a zeroing of the joystick, see loop()
+    // number of received output reports per entry of outputReports[] and one for unknown report ids
+    volatile uint16_t outputReportCount[HIDOUTREPORT_HANDLERS + 1];
 
 protected:
     uint8_t endpointTypes[2];
@@ -0,0 +1,127 @@
+/*
+ * Interrupt driven acquisition of the analog channels.
+ *
+ * analogRead() starts a conversion and spins until it is done (~110 us on the 32u4). Reading all
+ * eight channels this way blocks the loop() for almost one millisecond.
+ * Instead, the ADC-complete-interrupt stores the result, selects the next channel of PINLIST and
+ * starts the next conversion. So the ADC round-robins through all channels in the background.
+ * A completed set of eight values (a frame) is published by switching between two buffers:
+ * The ISR fills one frame, while the other one holds the latest complete frame for the loop().
+ *
+ * With ADC_OVERSAMPLING, all channels are converted ADC_SAMPLES times per frame. The conversions of
+ * each channel are summed up and decimated to ADC_EXTRA_BITS more bits, when the frame is complete.
+ */
+
+#include <Arduino.h>
+#include "config.h"
+
+#ifdef ADC_ISR
+  #include "adcSampler.h"
+  #include "kinematics.h"
+
+  static uint8_t adcMux[8];        // ADC multiplexer channel for every entry in PINLIST
+  static uint8_t adcRefBits;       // reference selection bits (REFS1, REFS0) for ADMUX
+  static bool    adcRunning = false;
+
+  static const int8_t adcInvertList[8] = INVERTLIST;
+
+  static volatile int     adcFrames[2][8];   // double buffered frames
+  static volatile uint8_t adcFillIdx = 0;    // frame, which is filled by the ISR right now
+  static volatile uint8_t adcFrameCount = 0; // incremented with every completed frame
+  static uint8_t          adcChannel = 0;    // entry of PINLIST, which is converted right now
+  static uint8_t          adcRound = 0;      // how often all channels were converted for this frame
+  static uint16_t         adcSum[8];         // sum of the conversions for the oversampling
+
+  /// @brief Set the multiplexer to the channel of PINLIST[ch]. The reference is set, too.
+  /// @param ch index in the PINLIST
+  static inline void adcSelectChannel(uint8_t ch) {
+    uint8_t mux = adcMux[ch];
+    // the 32u4 has a sixth mux bit in ADCSRB for the channels ADC8 .. ADC13
+    ADCSRB = (ADCSRB & ~(1 << MUX5)) | (((mux >> 3) & 0x01) << MUX5);
+    ADMUX = adcRefBits | (mux & 0x07);
+  }
+
+  /// @brief ADC conversion complete: store the value and start the conversion of the next channel
+  ISR(ADC_vect) {
+    uint16_t sum = adcSum[adcChannel] + ADC; // reads ADCL before ADCH, as required
+
+    if (adcRound == ADC_SAMPLES - 1) {
+      // last conversion of this channel for the frame: decimate and store the value
+      int value = sum >> ADC_EXTRA_BITS;
+      if (adcInvertList[adcChannel] == 1) {
+        value = ADC_MAXVAL - value;
+      }
+      adcFrames[adcFillIdx][adcChannel] = value;
+      sum = 0;
+    }
+    adcSum[adcChannel] = sum;
+
+    if (++adcChannel >= 8) {
+      adcChannel = 0;
+      if (++adcRound >= ADC_SAMPLES) {
+        // frame complete: publish it and fill the other one
+        adcRound = 0;
+        adcFillIdx ^= 1;
+        adcFrameCount++;
+      }
+    }
+    adcSelectChannel(adcChannel);
+    ADCSRA |= (1 << ADSC); // start next conversion
+  }
+
+  /// @brief (Re-)Start the background acquisition. Call this again to change the reference voltage.
+  /// @param reference DEFAULT (5V) or INTERNAL (2.56V), as used by analogReference()
+  void adcStart(uint8_t reference) {
+    static const uint8_t pinList[8] = PINLIST;
+
+    // stop the round robin and let a running conversion finish
+    ADCSRA &= ~(1 << ADIE);
+    while (ADCSRA & (1 << ADSC)) {
+    }
+
+    for (uint8_t i = 0; i < 8; i++) {
+      uint8_t pin = pinList[i];
+      if (pin >= A0) {
+        pin -= A0; // allow for channel or pin numbers, like analogRead() does
+      }
+      adcMux[i] = analogPinToChannel(pin);
+    }
+    adcRefBits = reference << 6;
+
+    for (uint8_t i = 0; i < 8; i++) {
+      adcSum[i] = 0;
+    }
+    adcRound = 0;
+    adcChannel = 0;
+    adcSelectChannel(adcChannel);
+    // the prescaler (128 -> 125 kHz ADC clock) and ADEN are already set by the Arduino init()
+    ADCSRA |= (1 << ADEN) | (1 << ADIE) | (1 << ADSC);
+    adcRunning = true;
+  }
+
+  /// @brief Copy the latest complete frame of the background acquisition.
+  /// @param rawReads pointer to 8 analog values
+  /// @param waitForNewFrame if true, wait for a frame, which has not been read before
+  /// @return true, if the frame hasn't been read before
+  bool adcReadFrame(int *rawReads, bool waitForNewFrame) {
+    static uint8_t lastFrameCount = 0;
+
+    if (waitForNewFrame && adcRunning) {
+      while (adcFrameCount == lastFrameCount) {
+      }
+    }
+
+    // The copy must not be interrupted by the ISR completing another frame, because the ISR would
+    // start to fill exactly this buffer. Copying takes only a few us.
+    noInterrupts();
+    volatile int *frame = adcFrames[adcFillIdx ^ 1];
+    for (uint8_t i = 0; i < 8; i++) {
+      rawReads[i] = frame[i];
+    }
+    bool isNewFrame = (adcFrameCount != lastFrameCount);
+    lastFrameCount = adcFrameCount;
+    interrupts();
+
+    return isNewFrame;
+  }
+#endif // whole file is only implemented #ifdef ADC_ISR
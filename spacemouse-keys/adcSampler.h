@@ -0,0 +1,6 @@
+// This is the public header for the adcSampler.cpp file
+// Background acquisition of the eight analog channels, driven by the ADC-complete-interrupt
+
+void adcStart(uint8_t reference);
+
+bool adcReadFrame(int *rawReads, bool waitForNewFrame);
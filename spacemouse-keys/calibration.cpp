@@ -1,6 +1,7 @@
 // File for calibration specific functions
 
 #include <Arduino.h>
+#include <EEPROM.h>
 #include "calibration.h"
 #include "kinematics.h"
 #include "config.h"
@@ -115,6 +116,18 @@ void debugOutput5(int* centered, int16_t* velocity) {
   }
 }
 
+/// @brief Stream the centered values after the deadzone and scaling, which are the input of the mixing matrix, for
+/// the calibration tool progModePy/calibrateMixing.py. One line like {AX, AY, BX, BY, CX, CY, DX, DY} every
+/// CALIBRATION_STREAM_MS.
+/// @param centered pointer to centered array
+void debugOutput21(int* centered) {
+  static unsigned long lastOutput = 0;  // time from millis(), when the last line was sent
+
+  if (millis() - lastOutput >= CALIBRATION_STREAM_MS) {
+    lastOutput = millis();
+    printArray(centered, 8);
+  }
+}
 
 #ifndef HALLEFFECT
 #define MINMAX_MINWARNING (-250)
@@ -127,8 +140,9 @@ void debugOutput5(int* centered, int16_t* velocity) {
 
 /// @brief This function records the minimum and maximum movement of the joysticks: After initialization, move the mouse for 20s and see the printed output.
 /// @param centered pointer to the array with the centered joystick values
+/// @param par parameters, the results are written to MINVALS and MAXVALS
 /// @return returns 0 if calculations are done, else 1 while collecting data and 2 while calculating
-int calcMinMax(int* centered) {    // report internal state as function-result to inform calling loop()
+int calcMinMax(int* centered, ParamData& par) {    // report internal state as function-result to inform calling loop()
   // Variables and function to get the min and maximum value of the centered values
   static int minMaxCalcState = 0;  // little state machine -> setup in 0 -> measure in 1 -> output in 2 ->  ends with 0
   static int minValue[8];          // Array to store the minimum values
@@ -139,8 +153,8 @@ int calcMinMax(int* centered) {    // report internal state as function-result t
     delay(2000);
     // Initialize the arrays
     for (int i = 0; i < 8; i++) {
-      minValue[i] = +1023; // Set the min value to the maximum possible value
-      maxValue[i] = -1023;  // Set the max value to the minimum possible value
+      minValue[i] = +ADC_MAXVAL; // Set the min value to the maximum possible value
+      maxValue[i] = -ADC_MAXVAL;  // Set the max value to the minimum possible value
     }
     startTime = millis(); // Record the current time
     minMaxCalcState = 1;  // next State: measure!
@@ -160,6 +174,11 @@ int calcMinMax(int* centered) {    // report internal state as function-result t
     }
 
   } else if (minMaxCalcState == 2) {
+    // MINVALS and MAXVALS are given in 10 bit values, independent of the oversampling
+    for (int i = 0; i < 8; i++) {
+      minValue[i] = minValue[i] / ADC_SCALE;
+      maxValue[i] = maxValue[i] / ADC_SCALE;
+    }
     Serial.print(F("#define MINVALS ")); printArray(minValue, 8);
     Serial.print(F("#define MAXVALS ")); printArray(maxValue, 8);
     #ifdef HALLEFFECT
@@ -177,6 +196,23 @@ int calcMinMax(int* centered) {    // report internal state as function-result t
       //int centerPoint = (max - min) / 2;
       //Serial.print(F("Centerpoint: ")); Serial.print(centerPoint);
     #endif
+    // use the results right away: write them to the parameters MINVALS and MAXVALS.
+    // A channel, which hasn't been moved to both sides, keeps its old values.
+    bool allWritten = true;
+    for (int i = 0; i < 8; i++) {
+      if (minValue[i] < 0 && maxValue[i] > 0) {
+        par.values->minVals[i] = minValue[i];
+        par.values->maxVals[i] = maxValue[i];
+      } else {
+        allWritten = false;
+      }
+    }
+    parametersChanged(par);
+    if (allWritten) {
+      Serial.println(F("MINVALS and MAXVALS are used now. Save them to the EEPROM in the parameter menu (30)."));
+    } else {
+      Serial.println(F("Some axes were not moved in both directions, they keep their MINVALS and MAXVALS."));
+    }
     for(int i = 0; i < 8; i++){
       if(minValue[i] > MINMAX_MINWARNING){
         Serial.print(F("minValue["));
@@ -232,86 +268,229 @@ void updateFrequencyReport() {
   }
 }
 
-/// @brief Calibrate (=zero) the space mouse. The function is blocking other functions of the spacemouse during zeroing.
-/// @param centerPoints 
-/// @param numIterations How many readings are taken to calculate the mean. Suggestion: 500 iterations, they take approx. 480ms.
-/// @param debugFlag With debugFlag = true, a suggestion for the dead zone is given on the serial interface to save to the config.h
-/// @return returns true, if no warnings occured. Warnings are given if the zero positions are very unlikely
-bool busyZeroing(int *centerPoints, uint16_t numIterations, boolean debugFlag){
-  bool noWarningsOccured = true;
+// state of the zeroing, which is shared by startZeroing() and zeroingStep()
+static uint32_t zeroSum[8];          // sum of all values during the averaging
+static int16_t  zeroMin[8];          // minimum values for the dead zone evaluation
+static int16_t  zeroMax[8];          // maximum values for the dead zone evaluation
+static uint16_t zeroCount      = 0;  // number of readings taken so far
+static uint16_t zeroIterations = 0;  // number of readings to take, 0 = no zeroing running
+static uint8_t  zeroFlags      = 0;  // ZEROING_REPORT, ZEROING_STORE, ...
 
-  if (debugFlag == true){
+/// @brief Start (or restart) the zeroing of the space mouse. The zeroing takes one reading in every call of
+/// zeroingStep(), so it doesn't block the other functions of the space mouse.
+/// @param numIterations How many readings are taken to calculate the mean. Suggestion: 500 iterations, they take approx. 480ms.
+/// @param flags ZEROING_REPORT, ZEROING_STORE, ZEROING_KEEP, ZEROING_BACKGROUND or 0, see calibration.h
+void startZeroing(uint16_t numIterations, uint8_t flags){
+  if (flags & ZEROING_REPORT){
     #ifndef HALLEFFECT
       Serial.println(F("Zeroing Joysticks..."));
     #else
       Serial.println(F("Zeroing HALL Sensors..."));
     #endif
   }
+  for (uint8_t i = 0; i < 8; i++){
+    zeroSum[i] = 0;
+    zeroMin[i] = ADC_MAXVAL; // Set the min value to the maximum possible value
+    zeroMax[i] = 0;          // Set the max value to the minimum possible value
+  }
+  zeroCount      = 0;
+  zeroFlags      = flags;
+  zeroIterations = numIterations;
+}
 
-  int      act[8];      // actual value
-  uint32_t mean[8];     // Array to count all values during the averaging
-  int16_t  minValue[8]; // Array to store the minimum values
-  int16_t  maxValue[8]; // Array to store the maximum values
+/// @brief Is a zeroing running?
+bool isZeroing(){
+  return zeroIterations != 0;
+}
 
-  for (int i = 0; i < 8; i++){
-    mean[i]     = 0;
-    minValue[i] = 1023; // Set the min value to the maximum possible value
-    maxValue[i] = 0;    // Set the max value to the minimum possible value
-  }
+/// @brief Shall the velocity be zero, because the center points are just being zeroed?
+/// A zeroing with ZEROING_BACKGROUND doesn't hold the velocity, because the old center points are still valid.
+bool zeroingHoldsVelocity(){
+  return isZeroing() && !(zeroFlags & ZEROING_BACKGROUND);
+}
 
-  for (uint16_t count = 0; count < numIterations; count++){
-    readAllFromJoystick(act);
-    for (uint8_t i = 0; i < 8; i++){
-      // Add to mean
-      mean[i] += act[i];
-      // Update the minimum and maximum values for dead zone evaluation
-      if (act[i] < minValue[i]){minValue[i] = act[i];}
-      if (act[i] > maxValue[i]){maxValue[i] = act[i];}
-    }
+/// @brief Take one reading for the zeroing and commit the new center points after the last reading.
+/// The center points are only changed after the last reading, all at once.
+/// @param raw raw values of one new frame
+/// @param centerPoints center points (input and output)
+/// @param par storage of parameters
+/// @return ZEROING_IDLE, ZEROING_RUNNING, ZEROING_DONE, ZEROING_WARNED or ZEROING_KEPT, see calibration.h
+uint8_t zeroingStep(int *raw, int *centerPoints, ParamData& par){
+  if (!isZeroing()){
+    return ZEROING_IDLE;
   }
 
-  int16_t deadZone[8];
-  int16_t maxDeadZone = 0;
-  // calculating average by dividing the mean by the number of iterations
   for (uint8_t i = 0; i < 8; i++){
-    centerPoints[i] = mean[i] / numIterations;
-    deadZone[i]     = maxValue[i] - minValue[i];
-    // get maximum deadzone independet of axis
-    if (deadZone[i] > maxDeadZone){maxDeadZone = deadZone[i];}
+    // Add to mean
+    zeroSum[i] += raw[i];
+    // Update the minimum and maximum values for dead zone evaluation
+    if (raw[i] < zeroMin[i]){zeroMin[i] = raw[i];}
+    if (raw[i] > zeroMax[i]){zeroMax[i] = raw[i];}
+  }
+  zeroCount++;
+  if (zeroCount < zeroIterations){
+    return ZEROING_RUNNING;
   }
 
-  // report everything, if with debugFlag
-  if (debugFlag){
+  bool    noWarningsOccured = true;
+  bool    report            = zeroFlags & ZEROING_REPORT;
+  int16_t maxDeadZone       = 0;
+
+  // check the result and report everything, if with ZEROING_REPORT
+  if (report){
     Serial.println(F("##  Min - Mean- Max -> Dead Zone"));
-    for (int i = 0; i < 8; i++){
+  }
+  for (uint8_t i = 0; i < 8; i++){
+    // calculating average by dividing the sum by the number of iterations, the sum is reused for the mean
+    zeroSum[i] /= zeroIterations;
+    int mean = zeroSum[i];
+    // the dead zone is given in 10 bit values (rounded up), independent of the oversampling
+    int16_t deadZone = (zeroMax[i] - zeroMin[i] + ADC_SCALE - 1) / ADC_SCALE;
+    // get maximum deadzone independet of axis
+    if (deadZone > maxDeadZone){maxDeadZone = deadZone;}
+
+    bool moved       = deadZone > DEADZONEWARNING;
+    bool notCentered = mean < CENTERPOINTWARNINGMIN * ADC_SCALE || mean > CENTERPOINTWARNINGMAX * ADC_SCALE;
+    // a re-centering in the background must not move the center points further than the drift compensation would
+    if ((zeroFlags & ZEROING_BACKGROUND) && abs(mean - centerPoints[i]) > par.values->compCenterDiff * ADC_SCALE){
+      moved = true;
+    }
+    if (moved || notCentered){
+      noWarningsOccured = false;
+    }
+    if (report){
       Serial.print(axisNames[i]);
       Serial.print(" ");
-      Serial.print(minValue[i]);
+      Serial.print(zeroMin[i]);
       Serial.print(" - ");
-      Serial.print(centerPoints[i]);
+      Serial.print(mean);
       Serial.print(" - ");
-      Serial.print(maxValue[i]);
+      Serial.print(zeroMax[i]);
       Serial.print(" -> ");
-      Serial.print(deadZone[i]);
+      Serial.print(deadZone);
       Serial.print(" ");
-      if (deadZone[i] > DEADZONEWARNING){
-        noWarningsOccured = false;
+      if (moved){
         Serial.print(F(" Moved axis?"));
       }
-      if (centerPoints[i] < CENTERPOINTWARNINGMIN || centerPoints[i] > CENTERPOINTWARNINGMAX){
-        noWarningsOccured = false;
+      if (notCentered){
         Serial.print(F(" Axis not centered?"));
       }
       Serial.println("");
     }
-    Serial.println(F("Using mean as zero position."));
+  }
+  zeroIterations = 0;
+
+  uint8_t result = noWarningsOccured ? ZEROING_DONE : ZEROING_WARNED;
+  if (!noWarningsOccured && (zeroFlags & (ZEROING_KEEP | ZEROING_BACKGROUND))){
+    result = ZEROING_KEPT;
+  } else {
+    // commit all new center points at once
+    for (uint8_t i = 0; i < 8; i++){
+      centerPoints[i] = zeroSum[i];
+    }
+  }
+#ifdef FAST_START
+  if (result == ZEROING_DONE && (zeroFlags & ZEROING_STORE)){
+    putCenterPointsToEEPROM(centerPoints);
+    if (report){
+      Serial.println(F("Zero position stored for the fast start."));
+    }
+  }
+#endif
+
+  if (report){
+    if (result == ZEROING_KEPT){
+      Serial.println(F("Keeping the previous zero position."));
+    } else {
+      Serial.println(F("Using mean as zero position."));
+    }
     Serial.print(F("Suggestion for config.h: "));
     Serial.print(F("#define DEADZONE "));
     Serial.println(maxDeadZone);
   }
-  return noWarningsOccured;
+  return result;
 }
 
+/// @brief Calibrate (=zero) the space mouse. The function is blocking other functions of the spacemouse during zeroing.
+/// Use startZeroing() and zeroingStep() to zero the space mouse without blocking.
+/// @param centerPoints center points (output)
+/// @param numIterations How many readings are taken to calculate the mean.
+/// @param par storage of parameters
+/// @return returns true, if no warnings occured. Warnings are given if the zero positions are very unlikely
+bool busyZeroing(int *centerPoints, uint16_t numIterations, ParamData& par){
+  int     act[8];
+  uint8_t result;
+
+  startZeroing(numIterations, 0);
+  do {
+    readAllFromJoystick(act, true);
+    result = zeroingStep(act, centerPoints, par);
+  } while (result == ZEROING_RUNNING);
+  return result == ZEROING_DONE;
+}
+
+#ifdef FAST_START
+/// @brief Read the center points of the last validated zeroing from the EEPROM
+/// @param centerPoints center points (output, only valid if true is returned)
+/// @return true, if valid center points for this firmware were found
+bool getCenterPointsFromEEPROM(int *centerPoints){
+  long magicNumber;
+  EEPROM.get(BASE_ADDRESS_CENTER_MAGIC, magicNumber);
+  if (magicNumber != CENTER_MAGIC_NUMBER){
+    return false;
+  }
+  for (uint8_t i = 0; i < 8; i++){
+    EEPROM.get(BASE_ADDRESS_CENTER + i * sizeof(int), centerPoints[i]);
+  }
+  return true;
+}
+
+/// @brief Store validated center points in the EEPROM for the next fast start.
+/// Only changed bytes are written, so storing the same center points again doesn't wear the EEPROM.
+/// @param centerPoints center points, which were taken by a zeroing without warnings
+void putCenterPointsToEEPROM(int *centerPoints){
+  long magicNumber = CENTER_MAGIC_NUMBER;
+  for (uint8_t i = 0; i < 8; i++){
+    EEPROM.put(BASE_ADDRESS_CENTER + i * sizeof(int), centerPoints[i]);
+  }
+  EEPROM.put(BASE_ADDRESS_CENTER_MAGIC, magicNumber);
+}
+
+/// @brief Zeroing at the start of the space mouse, which restores the stored center points if possible.
+/// The stored center points are checked with a short burst of FAST_START_SAMPLES readings: The sensors must not move
+/// and the mean of every axis must be closer than COMP_CDIFF to the stored center point. The drift compensation
+/// takes care of the remaining difference.
+/// Otherwise a full zeroing is started in the background. If the full zeroing warns (e.g. the knob is touched while
+/// plugging in), the stored center points are more trustworthy than the new ones and are kept.
+/// @param centerPoints center points (output)
+/// @param par storage of parameters
+/// @return true, if the stored center points are used right away
+bool fastZeroing(int *centerPoints, ParamData& par){
+  int burst[8];
+
+  if (!getCenterPointsFromEEPROM(centerPoints)){
+    startZeroing(750, ZEROING_STORE);
+    return false;
+  }
+
+  if (busyZeroing(burst, FAST_START_SAMPLES, par)){
+    bool matching = true;
+    for (uint8_t i = 0; i < 8; i++){
+      if (abs(burst[i] - centerPoints[i]) > par.values->compCenterDiff * ADC_SCALE){
+        matching = false;
+      }
+    }
+    if (matching){
+      return true;
+    }
+  }
+
+  // the check failed: zero the sensors completely
+  startZeroing(750, ZEROING_STORE | ZEROING_KEEP);
+  return false;
+}
+#endif
+
 /// @brief  Compensate drifts of the joysticks / hall-sensors
 /// @param  raw    raw[]-array of joystick-values (input)
 /// @param  center centerPoints[]-array to determine drift (input)
@@ -330,7 +509,7 @@ void compensateDrifts(int *raw, int *center, int *offset, ParamData& par) {
 
   if(cmpRestart){                           // on restart calculation:
     for(int i=0; i<8; i++){
-      cmpMin[i]  = 1023;                    //   init min/max fields
+      cmpMin[i]  = ADC_MAXVAL;              //   init min/max fields
       cmpMax[i]  =    0;
       cmpMean[i] =    0;
     }
@@ -345,9 +524,9 @@ void compensateDrifts(int *raw, int *center, int *offset, ParamData& par) {
     if(r > cmpMax[i]){cmpMax[i] = r;}       //   latch if maximum
   }
 
-  for(int i=0; i<8; i++){                   // test new data:
-    if(abs(raw[i] - center[i]) > par.values->compCenterDiff){drifting = false;} // too far away from original center -> not drifting
-    if((cmpMax[i] - cmpMin[i]) > par.values->compMinMaxDiff){drifting = false;} // too much bandwidth -> not drifting 
+  for(int i=0; i<8; i++){                   // test new data (the limits are given in 10 bit values):
+    if(abs(raw[i] - center[i]) > par.values->compCenterDiff * ADC_SCALE){drifting = false;} // too far away from original center -> not drifting
+    if((cmpMax[i] - cmpMin[i]) > par.values->compMinMaxDiff * ADC_SCALE){drifting = false;} // too much bandwidth -> not drifting 
   }
 
   if(!drifting){                            // if not only drift:
@@ -5,14 +5,43 @@ void debugOutput1(int* rawReads, int* keyVals);
 void debugOutput2(int* centered);
 void debugOutput4(int16_t* velocity, uint8_t* keyOut);
 void debugOutput5(int* centered, int16_t* velocity);
+void debugOutput21(int* centered);
+
+// interval of the lines of debugOutput21(), much faster than DEBUGDELAY to get enough frames for the calibration
+#define CALIBRATION_STREAM_MS 10
 
 void printArray(int arr[], int size);
-int  calcMinMax(int* centered);
+int  calcMinMax(int* centered, ParamData& par);
 
 bool isDebugOutputDue();
 
 void updateFrequencyReport();
 
-bool busyZeroing(int *centerPoints, uint16_t numIterations, boolean debugFlag);
+// flags of startZeroing()
+#define ZEROING_REPORT     1 // report the result on the serial interface and give a suggestion for the dead zone
+#define ZEROING_STORE      2 // store the center points for the fast start, if no warnings occured
+#define ZEROING_KEEP       4 // keep the previous center points, if warnings occured
+#define ZEROING_BACKGROUND 8 // re-centering during normal use: don't hold the velocity, keep the previous center
+                             // points on warnings or if the new ones are further away than COMP_CDIFF
+
+// results of zeroingStep()
+#define ZEROING_IDLE    0 // no zeroing running
+#define ZEROING_RUNNING 1 // still collecting readings
+#define ZEROING_DONE    2 // new center points committed
+#define ZEROING_WARNED  3 // new center points committed, but warnings occured
+#define ZEROING_KEPT    4 // warnings occured, the previous center points were kept
+
+void    startZeroing(uint16_t numIterations, uint8_t flags);
+bool    isZeroing();
+bool    zeroingHoldsVelocity();
+uint8_t zeroingStep(int *raw, int *centerPoints, ParamData& par);
+bool    busyZeroing(int *centerPoints, uint16_t numIterations, ParamData& par);
+
+// number of readings to check the stored center points at a fast start
+#define FAST_START_SAMPLES 32
+
+bool getCenterPointsFromEEPROM(int *centerPoints);
+void putCenterPointsToEEPROM(int *centerPoints);
+bool fastZeroing(int *centerPoints, ParamData& par);
 
 void compensateDrifts(int *raw, int *center, int *offset, ParamData& par);
@@ -23,11 +23,14 @@
 #endif
 #endif
 
-// Check KEYLIST size matches NUMKEYS
+#include "spaceKeys.h" // NUMDIRECTKEYS and NUMMATRIXKEYS
+
+// Check KEYLIST size matches NUMKEYS (without the keys of the key matrix)
 #if NUMKEYS > 0
 constexpr int _keyListCompile[] = KEYLIST;
-static_assert(sizeof(_keyListCompile) / sizeof(_keyListCompile[0]) == NUMKEYS,
-              "KEYLIST element count does not match NUMKEYS definition in config.h");
+static_assert(sizeof(_keyListCompile) / sizeof(_keyListCompile[0]) == NUMDIRECTKEYS,
+              "KEYLIST element count does not match NUMKEYS definition in config.h (minus the keys "
+              "of KEYMATRIX_ROWS x KEYMATRIX_COLS)");
 
 constexpr bool _isValueInArray(const int *arr, int size, int idx, int value) {
   return (idx >= size)         ? false
@@ -36,21 +39,78 @@ constexpr bool _isValueInArray(const int *arr, int size, int idx, int value) {
 }
 // Check that LEDpin is not in KEYLIST to avoid pin conflicts
 #ifdef LEDpin
-static_assert(!_isValueInArray(_keyListCompile, NUMKEYS, 0, LEDpin),
+static_assert(!_isValueInArray(_keyListCompile, NUMDIRECTKEYS, 0, LEDpin),
               "LEDpin conflicts with a pin in KEYLIST in config.h");
 #endif
 
 // Check that ENCODER_CLK is not in KEYLIST to avoid pin conflicts
 #ifdef ENCODER_CLK
-static_assert(!_isValueInArray(_keyListCompile, NUMKEYS, 0, ENCODER_CLK),
+static_assert(!_isValueInArray(_keyListCompile, NUMDIRECTKEYS, 0, ENCODER_CLK),
               "ENCODER_CLK conflicts with a pin in KEYLIST in config.h");
 #endif
 
 // Check that ENCODER_DT is not in KEYLIST to avoid pin conflicts
 #ifdef ENCODER_DT
-static_assert(!_isValueInArray(_keyListCompile, NUMKEYS, 0, ENCODER_DT),
+static_assert(!_isValueInArray(_keyListCompile, NUMDIRECTKEYS, 0, ENCODER_DT),
               "ENCODER_DT conflicts with a pin in KEYLIST in config.h");
 #endif
+
+// Check the pins of the key matrix
+#ifdef KEYMATRIX_ROWS
+#if !defined(KEYMATRIX_NUMROWS) || !defined(KEYMATRIX_COLS) || !defined(KEYMATRIX_NUMCOLS)
+#error "KEYMATRIX_ROWS needs KEYMATRIX_NUMROWS, KEYMATRIX_COLS and KEYMATRIX_NUMCOLS in config.h"
+#endif
+constexpr int _keyMatrixRowsCompile[] = KEYMATRIX_ROWS;
+constexpr int _keyMatrixColsCompile[] = KEYMATRIX_COLS;
+static_assert(sizeof(_keyMatrixRowsCompile) / sizeof(_keyMatrixRowsCompile[0]) ==
+                  KEYMATRIX_NUMROWS,
+              "KEYMATRIX_ROWS element count does not match KEYMATRIX_NUMROWS in config.h");
+static_assert(sizeof(_keyMatrixColsCompile) / sizeof(_keyMatrixColsCompile[0]) ==
+                  KEYMATRIX_NUMCOLS,
+              "KEYMATRIX_COLS element count does not match KEYMATRIX_NUMCOLS in config.h");
+static_assert(KEYMATRIX_NUMROWS > 0 && KEYMATRIX_NUMCOLS > 0 && KEYMATRIX_NUMCOLS <= 16,
+              "The key matrix needs at least one row and between one and 16 columns");
+
+// true, if one of the values in arr is in other
+constexpr bool _isArrayInArray(const int *arr, int size, const int *other, int otherSize,
+                               int idx = 0) {
+  return (idx >= size)                                     ? false
+         : _isValueInArray(other, otherSize, 0, arr[idx]) ? true
+                                                          : _isArrayInArray(arr, size, other,
+                                                                            otherSize, idx + 1);
+}
+// true, if a value appears twice in arr
+constexpr bool _hasDuplicates(const int *arr, int size, int idx = 0) {
+  return (idx >= size)                                   ? false
+         : _isValueInArray(arr, size, idx + 1, arr[idx]) ? true
+                                                         : _hasDuplicates(arr, size, idx + 1);
+}
+static_assert(!_isArrayInArray(_keyMatrixRowsCompile, KEYMATRIX_NUMROWS, _keyListCompile,
+                               NUMDIRECTKEYS) &&
+                  !_isArrayInArray(_keyMatrixColsCompile, KEYMATRIX_NUMCOLS, _keyListCompile,
+                                   NUMDIRECTKEYS),
+              "A pin of KEYMATRIX_ROWS or KEYMATRIX_COLS conflicts with a pin in KEYLIST in config.h");
+static_assert(!_isArrayInArray(_keyMatrixRowsCompile, KEYMATRIX_NUMROWS, _keyMatrixColsCompile,
+                               KEYMATRIX_NUMCOLS) &&
+                  !_hasDuplicates(_keyMatrixRowsCompile, KEYMATRIX_NUMROWS) &&
+                  !_hasDuplicates(_keyMatrixColsCompile, KEYMATRIX_NUMCOLS),
+              "KEYMATRIX_ROWS and KEYMATRIX_COLS must not share a pin or contain a pin twice");
+#ifdef LEDpin
+static_assert(!_isValueInArray(_keyMatrixRowsCompile, KEYMATRIX_NUMROWS, 0, LEDpin) &&
+                  !_isValueInArray(_keyMatrixColsCompile, KEYMATRIX_NUMCOLS, 0, LEDpin),
+              "LEDpin conflicts with a pin of the key matrix in config.h");
+#endif
+#ifdef ENCODER_CLK
+static_assert(!_isValueInArray(_keyMatrixRowsCompile, KEYMATRIX_NUMROWS, 0, ENCODER_CLK) &&
+                  !_isValueInArray(_keyMatrixColsCompile, KEYMATRIX_NUMCOLS, 0, ENCODER_CLK),
+              "ENCODER_CLK conflicts with a pin of the key matrix in config.h");
+#endif
+#ifdef ENCODER_DT
+static_assert(!_isValueInArray(_keyMatrixRowsCompile, KEYMATRIX_NUMROWS, 0, ENCODER_DT) &&
+                  !_isValueInArray(_keyMatrixColsCompile, KEYMATRIX_NUMCOLS, 0, ENCODER_DT),
+              "ENCODER_DT conflicts with a pin of the key matrix in config.h");
+#endif
+#endif
 #endif
 
 // Check ROTARY_AXIS is in valid range (0-6)
@@ -63,4 +123,37 @@ static_assert(!_isValueInArray(_keyListCompile, NUMKEYS, 0, ENCODER_DT),
 #error "Only one of ROTARY_AXIS and ROTARY_KEYS may be enabled at the same time"
 #endif
 
+// Check ADC_OVERSAMPLING has one of the supported values
+#if defined(ADC_OVERSAMPLING) && (ADC_OVERSAMPLING != 1) && (ADC_OVERSAMPLING != 4) &&          \
+    (ADC_OVERSAMPLING != 16)
+#error "ADC_OVERSAMPLING must be 1, 4 or 16"
+#endif
+
+// Check the tables of the key map
+#ifdef KEYMAP
+#if NUMKEYS == 0
+#error "KEYMAP needs keys: NUMKEYS > 0"
+#endif
+#if !defined(KEYMAP_CHORDS) || (KEYMAP_CHORDS < 1) || (KEYMAP_CHORDS > 33)
+#error "KEYMAP needs KEYMAP_CHORDS between 1 and 33 in config.h"
+#endif
+constexpr int8_t _kmTapCompile[] = KM_TAP;
+constexpr int8_t _kmHoldCompile[] = KM_HOLD;
+constexpr int8_t _kmDoubleCompile[] = KM_DOUBLE;
+constexpr int8_t _kmChordCompile[] = KM_CHORD;
+constexpr int16_t _kmTimesCompile[] = KM_TIMES;
+static_assert(sizeof(_kmTapCompile) == 2 * NUMKEYS && sizeof(_kmHoldCompile) == 2 * NUMKEYS,
+              "KM_TAP and KM_HOLD need two buttons per key (layer 0 and 1): 2 * NUMKEYS elements");
+static_assert(sizeof(_kmDoubleCompile) == NUMKEYS, "KM_DOUBLE needs NUMKEYS elements");
+static_assert(sizeof(_kmChordCompile) == 3 * KEYMAP_CHORDS,
+              "KM_CHORD needs three elements per chord: 3 * KEYMAP_CHORDS elements");
+static_assert(sizeof(_kmTimesCompile) == 3 * sizeof(int16_t),
+              "KM_TIMES needs three times: long press, double tap and chord");
+#endif
+
+// The HID report layouts exclude each other
+#if defined(ADV_HID_COMBINED) && defined(ADV_HID_SPACENAV)
+#error "Only one of ADV_HID_COMBINED and ADV_HID_SPACENAV may be defined at the same time"
+#endif
+
 #endif // CALIBRATION_CHECKS_h
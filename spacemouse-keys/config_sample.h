@@ -38,10 +38,12 @@ Debug Modes:
 
 1:  Report raw joystick values. 0-1023 raw ADC 10-bit values
 11: Calibrate / Zero the SpaceMouse and get a dead-zone suggestion (This is also done on every
-startup in the setup())
+startup in the setup()). The zeroing runs in the background, the result is reported after 2000 loops.
 
 2:  Report centered joystick values. Values should be approximately -500 to +500, jitter around 0 at
 idle. 20: semi-automatic min-max calibration.
+21: Stream the values of debug 3 as {AX, AY, ...} lines every 10 ms. This is used by the calibration
+tool progModePy/calibrateMixing.py to calculate the mixing matrix.
 
 3:  Report centered joystick values. Filtered for deadzone. Approximately -350 to +350, locked to
 zero at idle, modified with a function.
@@ -51,6 +53,12 @@ zero at idle, modified with a function.
 6:  Report velocity and keys after possible kill-key feature
 61: Report velocity and keys after kill-switch or ExclusiveMode
 7:  Report the frequency of the loop() -> how often is the loop() called in one second?
+71: Report a histogram of the age of the HID reports once per second: time between reading the
+sensors and sending the report, see ADV_HID_SOF. The counters of the sent, coalesced (the host
+hadn't taken the previous report yet, one per HID_RATE), dropped and suppressed (ADV_HID_DELTA)
+reports follow, as well as the number of received output reports per report id (LED, calibrate and others).
+72: Print every sent HID report as "R <time in us> <report id> <data>" in hex. Compare it with a USB
+capture by progModePy/usbCapture.py. With a short HID_RATE, the serial interface may be too slow.
 8:  Report the bits and bytes send as button codes
 9:  Report details about the encoder wheel, if ROTARY_AXIS > 0 or ROTARY_KEYS>0
 */
@@ -130,7 +138,9 @@ Semi-automatic (debug=20)
 3. Move the Spacemouse around for 15s to get a min and max value.
 4. Verify, that the minimums are around -400 to -520 and the maxVals around +400 to +520.
    (repeat or check again, if you have too small values!)
-5. Copy the output from the console into your config.h below.
+5. The values are used right away (parameters MINVALS and MAXVALS). Save them to the EEPROM in the
+   parameter menu (30 -> 4), so you don't need to compile again.
+   Or copy the output from the console into your config.h below.
 
 Manual min/max calibration (debug = 2)
 --------------------------------------
@@ -304,6 +314,24 @@ driver to get expected behavior.
   50 // [incr] maximum distance from the center-value to be only drift (never compensates above this
      // offset)
 
+/* Zeroing and fast start
+==========================
+At every start, the sensors are zeroed with 750 readings (approx. 0.7 s). The zeroing runs in the
+background of the main loop, one reading per loop. The keys, LEDs and the serial interface keep working,
+but the velocity stays zero until the new zero position is taken. Debug mode 11 works the same way.
+The zero position is wrong, if the knob is touched while plugging in.
+With FAST_START, the zero position of the last successful zeroing is restored from the EEPROM and checked
+with 32 readings: If the sensors are not moving and closer than COMP_CDIFF to the stored zero position,
+the stored zero position is used. Otherwise the full zeroing is done and stored, if it didn't find a
+moved axis. Debug mode 11 stores its zero position as well.
+*/
+// #define FAST_START
+
+// With RECENTER_INTERVAL, the zeroing is repeated in the background every RECENTER_INTERVAL seconds
+// without holding the velocity. The new zero position is only taken, if no axis was moved during the
+// zeroing and every axis is closer than COMP_CDIFF to the previous zero position.
+// #define RECENTER_INTERVAL 60 // [s]
+
 /* Exclusive mode
 ==================
 Exclusive mode only permit to send translation OR rotation, but never both at the same time.
@@ -420,17 +448,71 @@ How many kill keys are there? (disabled: 0; enabled: 2)
  * => KILLROT 2 The second kill key has the last position in the KEYLIST with index 3 -> KILLTRANS 3
  */
 
-// time in ms which is needed to allow a new button press
-#define DEBOUNCE_KEYS_MS 200
+// time in ms between two samples of the keys for the debouncing. Pressing or releasing a key is
+// taken after four equal samples, i.e. after 20 ms with 5 ms.
+#define DEBOUNCE_SAMPLE_MS 5
+
+// With KEYS_ISR, the keys on port B (pins 8, 9, 10, 11, 14, 15, 16, 17 of the Pro Micro) are captured
+// by the pin change interrupt with the time of every edge. A press during a long loop() (e.g. debug
+// output or the LED ring) is not missed: the debouncing replays the edges at their time. The other
+// keys are read once per loop(). Debug mode 8 reports edges, which were lost.
+// #define KEYS_ISR
+
+/* Key Matrix
+--------------
+More keys than free pins: the keys are wired in a matrix of rows and columns, e.g. 3 rows and 4
+columns for 12 keys on 7 pins. The keys of the matrix follow the keys in KEYLIST: NUMKEYS counts
+both, the first matrix key (row 0, column 0) has the index NUMKEYS - rows * columns, the next one
+is in row 0, column 1 and so on. These indices are used in BUTTONLIST, KILLROT and KILLTRANS.
+The columns are pulled up, the rows are driven LOW one after the other. One row is read per loop().
+Without diodes, three pressed keys in a rectangle fake the fourth: such ambiguous keys keep their
+state. With a diode per key (cathode to the row), define KEYMATRIX_DIODES to skip this.
+At most 16 columns and 32 keys in total are possible.
+Example for 12 keys on seven pins without any keys in KEYLIST:
+NUMKEYS 12, KEYLIST { }, NUMHIDKEYS 12 and twelve elements in BUTTONLIST
+*/
+// #define KEYMATRIX_NUMROWS 3
+// #define KEYMATRIX_ROWS {0, 1, 7}
+// #define KEYMATRIX_NUMCOLS 4
+// #define KEYMATRIX_COLS {15, 14, 16, 10}
+// #define KEYMATRIX_DIODES
+
+/* Key Map
+-----------
+Instead of BUTTONLIST, the key map assigns the buttons (SM_...) to the keys with more functions:
+- KM_TAP: the button of a short press. With KM_LAYER, the key is a layer key: as long as it is
+  pressed, the second half of KM_TAP and KM_HOLD is used for the other keys.
+- KM_HOLD: the button of a long press, i.e. held for longer than the first time of KM_TIMES.
+- KM_DOUBLE: the button of a double tap within the second time of KM_TIMES.
+- KM_CHORD: three elements per chord: the index of two keys, which are pressed together within the
+  third time of KM_TIMES, and the button sent instead. A key belongs to one chord at most.
+Use KM_NONE for no button. KM_TAP and KM_HOLD have NUMKEYS elements for layer 0, followed by NUMKEYS
+elements for layer 1. A key without KM_HOLD and KM_DOUBLE sends its button without delay, otherwise
+a short press is sent on the release (or after the time of the double tap).
+The tables are array parameters, which are stored in the EEPROM and can be changed in the ProgMode.
+NUMHIDKEYS and BUTTONLIST are not used with KEYMAP. Debug mode 8 prints the sent buttons.
+Example for four keys with the fourth key as layer key:
+*/
+// #define KEYMAP
+// #define KEYMAP_CHORDS 1
+// #define KM_NONE -1
+// #define KM_LAYER -2
+// #define KM_TAP    {SM_FIT, SM_T, SM_R, KM_LAYER, SM_1, SM_2, SM_3, KM_NONE}
+// #define KM_HOLD   {SM_MENU, KM_NONE, KM_NONE, KM_NONE, SM_4, KM_NONE, KM_NONE, KM_NONE}
+// #define KM_DOUBLE {SM_ESC, KM_NONE, KM_NONE, KM_NONE}
+// #define KM_CHORD  {1, 2, SM_ROT}
+// #define KM_TIMES  {400, 250, 50}
 
 /* Encoder Wheel
 ================
 You can attach an encoder to the mouse, which acts as an input device for one movement.
-Needs the encoder library by Paul Stoffregen (https://www.pjrc.com/teensy/td_libs_Encoder.html).
+The encoder is decoded by the interrupts of its pins, like the encoder library by Paul Stoffregen does,
+or polled in every loop for ROTARY_KEYS without interrupt pins.
 */
 
-// Define the encoder pins
-// Swap those two pins to change direction of encoder
+// Define the encoder pins. Swap those two pins to change direction of encoder
+// Attention: Since version 3.0.4, ROTARY_AXIS needs two interrupt pins: 0, 1, 2, 3 or 7.
+// Other pins don't compile anymore with ROTARY_AXIS. ROTARY_KEYS polls other pins in every loop.
 #define ENCODER_CLK 2
 #define ENCODER_DT 3
 
@@ -447,12 +529,15 @@ Axis to replace with encoder
 */
 #define ROTARY_AXIS 0
 
-/* To calculate a velocity from the encoder position, the output is faded over so many loop()
-iterations, as defined in #RAXIS_ECH Small number = short duration of zooming <-> Big Number =
-longer duration of zooming Compare this number with the update frequency of the script, reported by
-debug=7: If RAXIS_ECH = frequency: the zoom is faded for 1 second.
+/* To calculate a velocity from the encoder position, every step of the encoder adds RAXIS_STR to
+the velocity, which then fades out exponentially with the time constant RAXIS_ECH in ms: after
+RAXIS_ECH ms, about a third of the velocity is left. Small number = short duration of zooming <->
+Big Number = longer duration of zooming. The fading is calculated from the time, so it doesn't
+depend on the frequency of the loop() (debug=7), see test/test_encoderWheel.cpp.
+Note: up to version 3.0.3, RAXIS_ECH was a number of loop() iterations. Half of the old value divided by the
+frequency of the loop in kHz gives about the same zoom, e.g. 200 iterations at 1 kHz -> 100 ms.
 */
-#define RAXIS_ECH 200
+#define RAXIS_ECH 100
 
 /* Strength of the simulated pull
 Recommended range: 0 - 350
@@ -515,6 +600,32 @@ FASTLED library. If set, the LEDRING gives the number of LEDs on the ring.
 // how often shall the LEDs be updated
 #define LEDUPDATERATE_MS 150
 
+/* Advanced ADC settings
+=========================
+Without ADC_ISR, the eight analog channels are read one after the other with analogRead() in every
+loop(). Each reading takes about 110 us, so the loop() waits almost 1 ms for the ADC.
+With ADC_ISR, the ADC reads the channels in the background, driven by its interrupt. The loop()
+just picks up the latest complete set of eight values and the loop frequency (debug = 7) increases.
+*/
+// #define ADC_ISR
+
+/* ADC_OVERSAMPLING 4 or 16 sums up four or sixteen conversions per channel and shifts the sum right by
+one or two bits. This gives 11 or 12 bit values with less noise, if the signal itself has some noise.
+The raw values (debug = 1) get larger by a factor of 2 or 4, but DEADZONE, MINVALS, MAXVALS and the
+COMP_ values are still given as 10 bit values, so you don't need to calibrate them again.
+The conversions take four or sixteen times longer, so use this together with ADC_ISR.
+*/
+#define ADC_OVERSAMPLING 1 // 1 = off, 4 = 11 bit, 16 = 12 bit
+
+/* Advanced kinematics settings
+================================
+Every axis is divided by its sensitivity (SENS_TX ... SENS_RZ) in every loop(). The controller has no
+floating point unit, so each of these divisions takes several hundred clock cycles.
+With KINEMATICS_FIXEDPOINT, the reciprocals of the sensitivities are calculated once, when the parameters
+are changed, and every axis needs only one integer multiplication. The velocities may differ by one.
+*/
+// #define KINEMATICS_FIXEDPOINT
+
 /* Advanced debug output settings
 =================================
 The following settings allow customization of debug output behavior */
@@ -570,4 +681,65 @@ value declared as absolute is resent with every report, because is not equal to
 // Add Jiggling to the value reported, if the following symbol is defined:
 // #define ADV_HID_JIGGLE
 
+/* ADV_HID_DELTA suppresses reports with unchanged axes
+By default, the axes are sent every HID_RATE, as long as one of them is not zero, even if the values
+are the same as in the last report. With ADV_HID_DELTA, such a repeated report is only sent as a
+keep-alive, ADV_HID_DELTA ms after the last one. This reduces the load of the USB and the driver, e.g.
+while the knob is held still. With ADV_HID_JIGGLE, only the keep-alive reports are jiggled (the last
+bit of the non-zero values is flipped), so that the host sees a change only then. The next report sends
+the real values again. Debug mode 71 counts the suppressed reports.
+*/
+// #define ADV_HID_DELTA 1000 // keep-alive [ms]
+
+/* HID timing
+HID_RATE is the time between two HID reports in ms: 1, 2, 4, 8 or 16. Other values are rounded down.
+A space mouse reports every 16 ms. Fast hosts accept e.g. 4 ms, which reduces the latency.
+HID_EPINT is the polling interval of the USB endpoints in ms, which is given to the host in the
+descriptor: 1, 2, 4, 8 or 16. 0 keeps the interval of former versions, which is chosen by the host.
+It should not be larger than HID_RATE. The host reads it only when the mouse is plugged in, so store
+it in the EEPROM and replug the mouse after changing it in the parameter menu.
+*/
+#define HID_RATE 16 // [ms]
+#define HID_EPINT 0 // [ms]
+
+/* ADV_HID_COMBINED sends the axes and the keys in one HID report
+By default, a SpaceMouse Pro is emulated: The six axes are sent in report 1 and the keys in report 3.
+Every report needs its own slot of HID_RATE (16 ms), so a key change during a motion is
+reported one slot later.
+With ADV_HID_COMBINED, report 1 carries the six axes and the 32 keys, report 3 is not used anymore.
+The 3Dconnexion drivers don't know this report. Use it only with hosts, which accept a generic
+multi-axis device, e.g. linux with spacenavd.
+*/
+// #define ADV_HID_COMBINED
+
+/* ADV_HID_SPACENAV emulates the split reports of a SpaceNavigator
+Older drivers and applications only know the SpaceNavigator (see SpaceNavigator.md): The translation is
+sent in report 1, the rotation in report 2 and two buttons in report 3. With ADV_HID_SPACENAV, both
+halves of one motion sample are sent right after each other in consecutive USB frames (approx. 1 ms),
+instead of one HID_RATE slot apart. Only the first two buttons are reported.
+"Calibrate" in the driver sends report 7, which starts a zeroing of the joystick (don't touch it).
+The USB IDs must match a SpaceNavigator (VID 0x046d, PID 0xc626): set_hwids.py does this for
+PlatformIO, if ADV_HID_SPACENAV is defined here. With the Arduino IDE, change the boards.txt.
+ADV_HID_SPACENAV and ADV_HID_COMBINED can't be used at the same time.
+*/
+// #define ADV_HID_SPACENAV
+
+/* ADV_HID_SOF aligns the sampling and the HID reports to the USB frames
+By default, the reports are scheduled with millis() and the sample in a report is taken, whenever
+loop() happens to run, so its age at the start of the slot varies by a whole loop(). With ADV_HID_SOF,
+the slots are counted in USB frames (start of frame, 1 ms) of the host. In the last loop() before the
+frame of the next report, the firmware waits for the start of this frame (at most 1 ms per report),
+then reads the sensors and sends the report. Check the result with debug mode 71.
+*/
+// #define ADV_HID_SOF
+
+/* ADV_HID_PARAMS adds a vendor defined feature report to read and write all parameters at once
+The parameters are usually edited via the serial interface (parameter menu or ProgMode), which is
+slow and mixes with the debug output. With ADV_HID_PARAMS, the whole parameter block (see ParamStorage
+in parameterMenu.h) is read and written with feature report 8 in a few control transfers.
+The tool progModePy/hidParams.py uses it via linux hidraw, e.g. to configure many mice the same way.
+Written parameters are saved to the EEPROM on request, if PARAM_IN_EEPROM is enabled.
+*/
+// #define ADV_HID_PARAMS
+
 #endif // CONFIG_h
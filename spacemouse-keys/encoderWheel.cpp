@@ -13,71 +13,169 @@
 #if ROTARY_AXIS > 0 or ROTARY_KEYS > 0
   #include "encoderWheel.h"
 
-  // Include Encoder library by Paul Stoffregen
-  #include <Encoder.h>
-  
-  Encoder myEncoder(ENCODER_CLK, ENCODER_DT);
-  
+  // The encoder is decoded by the interrupts of both pins, with the same steps as the Encoder library
+  // by Paul Stoffregen, and every transition is stored with its time from micros() in a ring buffer.
+  // The ISR is the only writer of encoderEventHead and calcEncoderWheel() the only writer of
+  // encoderEventTail.
+  // Without interrupt pins, the pins are polled by readEncoder() in every loop instead, like the
+  // Encoder library does. This is only good enough for ROTARY_KEYS, which needs no time of the steps.
+  static const bool encoderInterrupts = digitalPinToInterrupt(ENCODER_CLK) != NOT_AN_INTERRUPT &&
+                                        digitalPinToInterrupt(ENCODER_DT) != NOT_AN_INTERRUPT;
+  #if ROTARY_AXIS > 0
+  static_assert(encoderInterrupts,
+                "ROTARY_AXIS: ENCODER_CLK and ENCODER_DT must be interrupt pins: 0, 1, 2, 3 or 7");
+  #endif
+
+  #define ENCODEREVENTS 16 // size of the ring buffer, must be a power of two
+
+  struct EncoderEvent {
+    unsigned long us; // time of the transition
+    int16_t delta;    // steps of the transition
+  };
+  static volatile EncoderEvent encoderEvents[ENCODEREVENTS];
+  static volatile uint8_t encoderEventHead = 0; // next event to be written by the ISR
+  static volatile uint8_t encoderEventTail = 0; // next event to be taken by calcEncoderWheel()
+  static volatile int32_t encoderPosition = 0;
+  static uint8_t encoderPins;                   // last state of the pins: bit 0 CLK, bit 1 DT
+
+  // steps by the last and the new state of the pins: index = last | new << 2
+  static const int8_t encoderSteps[16] = {0, 1, -1, 2, -1, 0, -2, 1, 1, -2, 0, -1, 2, -1, 1, 0};
+
   int32_t previousEncoderValue = 0;
   int32_t newEncoderValue; // Store encoder readings
   int32_t delta = 0;       // Tracks encoder increments when turned
-  
-  float simpull;             // calculated velocity of the encoder wheel
-  
+
+  // The velocity of the encoder wheel is calculated from the time of the transitions: every
+  // transition adds RAXIS_STR per step to the velocity, which decays exponentially with the time
+  // constant RAXIS_ECH in ms. The velocity is only stored at the time of the last transition and
+  // decayed in one step to the time of the loop(), so it doesn't depend on the frequency of the loop().
+  float simpull;             // velocity of the encoder wheel at simpullTime
+  unsigned long simpullTime; // [us] time of the last transition
+
+  // an edge on one of the pins of the encoder, or a poll of the pins without interrupts
+  static void encoderISR() {
+    uint8_t pins = digitalRead(ENCODER_CLK) | (digitalRead(ENCODER_DT) << 1);
+    int8_t step = encoderSteps[encoderPins | (pins << 2)];
+    encoderPins = pins;
+    if (step == 0) {
+      return;
+    }
+    encoderPosition += step;
+    uint8_t next = (encoderEventHead + 1) & (ENCODEREVENTS - 1);
+    if (next == encoderEventTail) {
+      // the ring buffer is full: the step is added to the last stored transition
+      encoderEvents[(encoderEventHead - 1) & (ENCODEREVENTS - 1)].delta += step;
+      return;
+    }
+    encoderEvents[encoderEventHead].us = micros();
+    encoderEvents[encoderEventHead].delta = step;
+    encoderEventHead = next;
+  }
+
+  /// @brief Take the next transition of the encoder, which happened up to the time now
+  /// @param now    [us] time of this loop
+  /// @param event  (output) the transition
+  /// @return true, if a transition was taken
+  static bool takeEncoderEvent(unsigned long now, EncoderEvent &event) {
+    bool taken = false;
+    noInterrupts(); // the ISR may add steps to the last transition
+    uint8_t tail = encoderEventTail;
+    if (tail != encoderEventHead && (long)(encoderEvents[tail].us - now) <= 0) {
+      event.us = encoderEvents[tail].us;
+      event.delta = encoderEvents[tail].delta;
+      encoderEventTail = (tail + 1) & (ENCODEREVENTS - 1);
+      taken = true;
+    }
+    interrupts();
+    return taken;
+  }
+
+  // read the position of the encoder
+  static int32_t readEncoder() {
+    noInterrupts();
+    if (!encoderInterrupts) {
+      encoderISR();
+    }
+    int32_t position = encoderPosition;
+    interrupts();
+    return position;
+  }
+
   void initEncoderWheel(){
+    pinMode(ENCODER_CLK, INPUT_PULLUP);
+    pinMode(ENCODER_DT, INPUT_PULLUP);
+    encoderPins = digitalRead(ENCODER_CLK) | (digitalRead(ENCODER_DT) << 1);
+    simpullTime = micros();
+    if (encoderInterrupts) {
+      attachInterrupt(digitalPinToInterrupt(ENCODER_CLK), encoderISR, CHANGE);
+      attachInterrupt(digitalPinToInterrupt(ENCODER_DT), encoderISR, CHANGE);
+    }
     // Read initial value from encoder
-    newEncoderValue = myEncoder.read();
+    newEncoderValue = readEncoder();
   }
-  
+
+  /// @brief Calculate factor^n with O(log n) multiplications
+  static float powDecay(float factor, unsigned long n){
+    float result = 1.0;
+    while (n > 0 && result != 0){
+      if (n & 1){
+        result *= factor;
+      }
+      factor *= factor;
+      n >>= 1;
+    }
+    return result;
+  }
+
+  /// @brief Get the velocity of the encoder wheel at the time t
+  /// @param t       [us] time after the last transition
+  /// @param factor  decay per ms
+  static float decayedVelocity(unsigned long t, float factor){
+    if (simpull == 0){
+      return 0;
+    }
+    return simpull * powDecay(factor, (t - simpullTime) / 1000);
+  }
+
   /// @brief Calculate the encoder wheel and update the result in the velocity array
   /// @param velocity   Array with the velocity, which gets updated at position ROTARY_AXIS-1
   /// @param debugOut   Generate a debug output if true
   /// @param par        struct of parameters used by the system at runtime
   void calcEncoderWheel(int16_t *velocity, bool debugOut, ParamData& par){
-    static float factor = 1.0;
-    static int zoomIterator = par.values->rotAxisEchos; // Counter for echoing the delta through a number of loops for a smoother zoom animation
-  
-    // read encoder
-    newEncoderValue = myEncoder.read();
-    if (newEncoderValue != previousEncoderValue){
-      // position changed, how much?
-      delta = newEncoderValue - previousEncoderValue;
-      previousEncoderValue = newEncoderValue;
-      zoomIterator = 0;
-    }
-  
-    // Distribute encoder delta through the echoes in the loop and based on simulated axis chosen by the user
-    // Faded intensity for echoing the encoder reading.
-    if (zoomIterator < par.values->rotAxisEchos){
-      factor = 1.0 - (((float)zoomIterator) / (float)par.values->rotAxisEchos); // factor shall be between 0.0 and 1.0
-      simpull = (factor * par.values->rotAxisSimStrength) * delta;
-      zoomIterator++; // iterate
-      // add the velocity of the encoder wheel to one of the 6 axis
-      // the ROTARY_AXIS definition is one above the array definition used for the velocity array (see calibration.h)
-      // Therefore ROTARY_AXIS-1 is used to change the velocity value
-      velocity[ROTARY_AXIS - 1] = velocity[ROTARY_AXIS - 1] + simpull;
-    }else{
-      // fading has ended
-      simpull = 0;
+    unsigned long now = micros();
+    // decay per ms: exp(-1ms / RAXIS_ECH), approximated by 1 - 1ms / RAXIS_ECH
+    float factor = 1.0 - 1.0 / max(par.values->rotAxisEchos, 2);
+
+    // add the transitions up to now in the order of their time
+    EncoderEvent event;
+    while (takeEncoderEvent(now, event)){
+      float pull = decayedVelocity(event.us, factor);
+      pull += (float)par.values->rotAxisSimStrength * event.delta;
+      simpull = constrain(pull, -350, 350); // the velocity can't be reported beyond 350
+      simpullTime = event.us;
     }
-  
+    float pull = decayedVelocity(now, factor);
+
+    // add the velocity of the encoder wheel to one of the 6 axis
+    // the ROTARY_AXIS definition is one above the array definition used for the velocity array (see calibration.h)
+    // Therefore ROTARY_AXIS-1 is used to change the velocity value
+    velocity[ROTARY_AXIS - 1] = constrain(velocity[ROTARY_AXIS - 1] + pull, -350, 350);
+
     if(debugOut){
       // create debug output
       Serial.print(F("Enc Val: "));
-      Serial.print(newEncoderValue);
-      Serial.print(F(", factor: "));
-      Serial.print(factor);
+      Serial.print(readEncoder());
       Serial.print(F(", simpull: "));
-      Serial.println(simpull);
+      Serial.println(pull);
     }
   }
-  
+
   /// @brief Read out the encoder and treat as keystroke
   /// @param keyState  overwrite some keys with encoder movement
   /// @param debugOut  Generate a debug output if true
   void calcEncoderAsKey(uint8_t keyState[NUMKEYS], bool debugOut){
     // read encoder
-    newEncoderValue = myEncoder.read();
+    newEncoderValue = readEncoder();
     if (newEncoderValue != previousEncoderValue){
       // If the position changed, add this to delta. As long as delta != 0, report the key as pressed
       delta = (newEncoderValue - previousEncoderValue)*ROTARY_KEY_STRENGTH + delta;
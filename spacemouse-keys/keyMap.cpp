@@ -0,0 +1,166 @@
+/*
+ * The key map assigns the buttons of the space mouse (SM_...) to the keys, see KEYMAP in config_sample.h.
+ * In contrast to BUTTONLIST, a key can send different buttons on a short press, a long press and a
+ * double tap, a layer key switches all keys to a second set of buttons and two keys pressed together
+ * (a chord) send another button. The tables are array parameters, so they are stored in the EEPROM
+ * and can be changed in the ProgMode.
+ *
+ * Every key has a small state machine, which is advanced once per loop. So the time per loop only
+ * grows with the number of keys, not with the number of chords.
+ */
+
+#include <Arduino.h>
+#include "config.h"
+
+#ifdef KEYMAP
+  #include "keyMap.h"
+
+  // phases of the state machine of every key
+  #define KM_IDLE      0 // released
+  #define KM_CHORDWAIT 1 // pressed, waiting for the other key of the chord
+  #define KM_PRESSED   2 // pressed, waiting for the release or the long press
+  #define KM_TAPWAIT   3 // released after a short press, waiting for the second tap
+  #define KM_TAPOUT    4 // the button of a short press is sent for KEYMAP_TAP_MS
+  #define KM_HELD      5 // the button is sent until the key is released
+  #define KM_IGNORE    6 // the key is used up (layer key, first key of a chord) until it is released
+
+  // time in ms, for which the button of a short press or a double tap is reported
+  #define KEYMAP_TAP_MS 50
+
+  typedef struct _KeyMapState {
+    uint8_t  phase;
+    uint8_t  layer; // layer at the time the key was pressed
+    int8_t   func;  // the button sent in KM_TAPOUT and KM_HELD
+    uint16_t since; // lower 16 bits of millis() at the start of the phase
+  } KeyMapState;
+
+  static KeyMapState keyMapState[NUMKEYS];
+
+  // chord of every key (index in KM_CHORD) or -1, rebuilt if the parameters changed
+  static int8_t chordOf[NUMKEYS];
+  static bool chordsValid = false;
+  static uint8_t chordsRevision;
+
+  static void buildChords(ParamData& par) {
+    const int8_t *chords = par.values->kmChord;
+    for (int i = 0; i < NUMKEYS; i++) {
+      chordOf[i] = -1;
+    }
+    // a key belongs to the first chord with this key only
+    for (int c = 0; c < KEYMAP_CHORDS; c++) {
+      int8_t a = chords[3 * c];
+      int8_t b = chords[3 * c + 1];
+      if (a >= 0 && a < NUMKEYS && b >= 0 && b < NUMKEYS && a != b && chordOf[a] < 0 && chordOf[b] < 0) {
+        chordOf[a] = c;
+        chordOf[b] = c;
+      }
+    }
+  }
+
+  /// @brief Start sending a button
+  static void startFunc(KeyMapState& s, uint8_t phase, int8_t func, uint16_t now, int i, bool debugOut) {
+    s.phase = phase;
+    s.func = func;
+    s.since = now;
+    if (debugOut && func >= 0) {
+      Serial.print(F("KeyMap: key "));
+      Serial.print(i);
+      Serial.print(F(" -> button "));
+      Serial.println(func);
+    }
+  }
+
+  /// @brief Evaluate the key map: map the debounced keys to the bits of the buttons in the HID report
+  /// @param keyState  debounced state of all keys (1 = pressed), see evalKeys() and calcEncoderAsKey()
+  /// @param keyData   (output) four bytes with the bits of the buttons, see prepareKeyBytes()
+  /// @param par       struct of parameters used by the system at runtime with the tables of the key map
+  /// @param debugOut  Generate a debug output if true
+  void evalKeyMap(uint8_t* keyState, uint8_t* keyData, ParamData& par, bool debugOut) {
+    if (!chordsValid || chordsRevision != par.revision) {
+      buildChords(par);
+      chordsValid = true;
+      chordsRevision = par.revision;
+    }
+    const ParamStorage *p = par.values;
+    uint16_t now = millis();
+
+    // the second layer is active, as long as a layer key is pressed
+    uint8_t layer = 0;
+    for (int i = 0; i < NUMKEYS; i++) {
+      if (keyState[i] && p->kmTap[i] == KM_LAYER) {
+        layer = 1;
+      }
+    }
+
+    memset(keyData, 0, 4);
+    for (int i = 0; i < NUMKEYS; i++) {
+      KeyMapState &s = keyMapState[i];
+      bool down = keyState[i];
+      uint16_t elapsed = now - s.since;
+      int8_t tap = p->kmTap[s.layer * NUMKEYS + i];
+      int8_t hold = p->kmHold[s.layer * NUMKEYS + i];
+      int8_t dbl = p->kmDouble[i];
+
+      switch (s.phase) {
+      case KM_IDLE:
+        if (down) {
+          s.phase = (chordOf[i] >= 0) ? KM_CHORDWAIT : KM_PRESSED;
+          s.layer = layer;
+          s.since = now;
+        }
+        break;
+      case KM_CHORDWAIT: {
+        int8_t c = chordOf[i];
+        int8_t other = p->kmChord[3 * c] == i ? p->kmChord[3 * c + 1] : p->kmChord[3 * c];
+        if (down && keyState[other] && keyMapState[other].phase == KM_CHORDWAIT) {
+          // both keys pressed within KM_TIMES[2]: this key sends the chord, the other one is used up
+          startFunc(s, KM_HELD, p->kmChord[3 * c + 2], now, i, debugOut);
+          keyMapState[other].phase = KM_IGNORE;
+        } else if (!down || elapsed >= (uint16_t)p->kmTimes[2]) {
+          s.phase = KM_PRESSED; // no chord, the time of the long press still counts from the press
+        }
+        break;
+      }
+      case KM_PRESSED:
+        if (p->kmTap[i] == KM_LAYER) {
+          s.phase = KM_IGNORE; // the layer key itself sends nothing
+        } else if (hold < 0 && dbl < 0) {
+          // a usual button without delay. A key of a chord may have been released already, while
+          // waiting for the other key: then its button is sent as a short press.
+          startFunc(s, down ? KM_HELD : KM_TAPOUT, tap, now, i, debugOut);
+        } else if (!down) {
+          if (dbl >= 0) {
+            s.phase = KM_TAPWAIT;
+            s.since = now;
+          } else {
+            startFunc(s, KM_TAPOUT, tap, now, i, debugOut);
+          }
+        } else if (hold >= 0 && elapsed >= (uint16_t)p->kmTimes[0]) {
+          startFunc(s, KM_HELD, hold, now, i, debugOut);
+        }
+        break;
+      case KM_TAPWAIT:
+        if (down) {
+          startFunc(s, KM_HELD, dbl, now, i, debugOut);
+        } else if (elapsed >= (uint16_t)p->kmTimes[1]) {
+          startFunc(s, KM_TAPOUT, tap, now, i, debugOut);
+        }
+        break;
+      case KM_TAPOUT:
+        if (elapsed >= KEYMAP_TAP_MS) {
+          s.phase = KM_IDLE;
+        }
+        break;
+      default: // KM_HELD and KM_IGNORE
+        if (!down) {
+          s.phase = KM_IDLE;
+        }
+        break;
+      }
+
+      if ((s.phase == KM_HELD || s.phase == KM_TAPOUT) && s.func >= 0 && s.func < 32) {
+        keyData[s.func / 8] |= (1 << (s.func % 8));
+      }
+    }
+  }
+#endif // whole file is only implemented #ifdef KEYMAP
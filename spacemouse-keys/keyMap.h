@@ -0,0 +1,6 @@
+// Header file for the keyMap.cpp
+// Map the keys to the buttons of the space mouse with layers, long press, double tap and chords
+
+#include "parameterMenu.h"
+
+void evalKeyMap(uint8_t* keyState, uint8_t* keyData, ParamData& par, bool debugOut);
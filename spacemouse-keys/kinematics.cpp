@@ -12,6 +12,9 @@
 #include "parameterMenu.h"
 #include "kinematics.h"
 #include "calibration.h"
+#ifdef ADC_ISR
+#include "adcSampler.h"
+#endif
 
 // Do not change this! Use independent sensitivity multipliers.
 #define TOTALSENSITIVITY 350
@@ -62,41 +65,201 @@ int modifierFunction(int x, ParamData& par) {
   return (int)round(y);
 }
 
+/**--- Lookup table for the modifier function
+// modifierFunction() needs pow() and tan() in (soft-)float, which is much too slow to be called for five axes in every loop.
+// Therefore, the curve is approximated by straight lines between some knots and only these are calculated by modifierFunction().
+//
+// 1. the curve is point symmetric, so only x = 0 ... +350 is stored
+// 2. the knots are placed greedily: a line from the last knot is extended as long as it stays within
+//    MODTABLE_TOLERANCE of every integer result of modifierFunction() in between ("swinging door")
+// 3. steep or strongly bent parts get many knots, straight parts only a few. With a tolerance of one count
+//    all reasonable curves (a = 0.5 ... 3, b up to 1.57) need at most 20 knots, the linear one only two.
+// 4. if more than MODTABLE_KNOTS would be needed, the table is built again with twice the tolerance
+// 5. the table is rebuilt by updateKinematicTables(), when MODFUNC, MOD_A or MOD_B have been changed
+*/
+#define MODTABLE_KNOTS    24
+#define MODTABLE_TOLERANCE 1.0
+
+static int16_t modTableX[MODTABLE_KNOTS]; // x of the knots, rising from 0 to TOTALSENSITIVITY
+static int16_t modTableY[MODTABLE_KNOTS]; // result of modifierFunction() at the knots
+static bool    modTableValid = false;
+static int8_t  modTableFunc;              // parameters of the table
+static double  modTableA, modTableB;
+
+/// @brief Build the lookup table for modifierTable() from the modifierFunction()
+static void buildModifierTable(ParamData& par) {
+  double tolerance = MODTABLE_TOLERANCE;
+  uint8_t n;
+
+  do {
+    n = 0;
+    int16_t x0 = 0;                             // start of the actual line
+    int16_t y0 = modifierFunction(0, par);
+    modTableX[n] = x0;
+    modTableY[n] = y0;
+    n++;
+
+    double  minSlope = -1e9, maxSlope = 1e9;   // slopes, which stay within the tolerance of all points since x0
+    int16_t lastX = x0, lastY = y0;             // last end of a line, which was within the tolerance
+    int16_t x = x0 + 1;
+    while (n < MODTABLE_KNOTS) {
+      int16_t y = modifierFunction(x, par);
+      double slope = (double)(y - y0) / (x - x0);
+      if (slope >= minSlope && slope <= maxSlope) {
+        lastX = x;
+        lastY = y;
+      }
+      minSlope = max(minSlope, (y - tolerance - y0) / (x - x0));
+      maxSlope = min(maxSlope, (y + tolerance - y0) / (x - x0));
+
+      if (minSlope > maxSlope || x == TOTALSENSITIVITY) {
+        // no line can reach beyond x: set a knot at the last possible end and start a new line there
+        modTableX[n] = lastX;
+        modTableY[n] = lastY;
+        n++;
+        if (lastX == TOTALSENSITIVITY) {
+          break;
+        }
+        x0 = lastX;
+        y0 = lastY;
+        minSlope = -1e9;
+        maxSlope = 1e9;
+        x = x0;
+      }
+      x++;
+    }
+    tolerance *= 2;
+  } while (modTableX[n - 1] != TOTALSENSITIVITY);
+}
+
+/// @brief Same as modifierFunction(), but interpolated in the lookup table, see updateKinematicTables()
+/// @param x input between -350 and +350
+/// @return output between -350 and +350, within one count of modifierFunction()
+int modifierTable(int x, ParamData& par) {
+  x = constrain(x, -TOTALSENSITIVITY, +TOTALSENSITIVITY);
+  int16_t xn = abs(x);
+
+  // search the line for xn. The last knot is at TOTALSENSITIVITY, so the search ends within the table.
+  uint8_t i = 1;
+  while (modTableX[i] < xn) {
+    i++;
+  }
+  int16_t width = modTableX[i] - modTableX[i - 1];
+  int32_t rise  = (int32_t)(modTableY[i] - modTableY[i - 1]) * (xn - modTableX[i - 1]);
+  // linear interpolation, rounded to the nearest integer
+  int16_t y = modTableY[i - 1] + (rise >= 0 ? (rise + width / 2) / width : -((-rise + width / 2) / width));
+
+  return (x < 0) ? -y : y;
+}
+
 /// @brief Function to read and store analogue voltages for each joystick axis.
 /// @param rawReads pointer to 8 analog values
-void readAllFromJoystick(int *rawReads){
+/// @param waitForNewFrame with ADC_ISR: wait for a frame, which hasn't been read before. Without ADC_ISR, every reading is new.
+/// @return true, if new values have been read
+bool readAllFromJoystick(int *rawReads, bool waitForNewFrame){
+#ifdef ADC_ISR
+  // the ADC is running in the background, just pick up the latest complete frame
+  return adcReadFrame(rawReads, waitForNewFrame);
+#else
   // define an array for reading the analog pins of the joysticks, see config.h
   static int pinList[8] = PINLIST;
   static int invertList[8] = INVERTLIST;
 
   for (int i = 0; i < 8; i++) {
+    // oversampling: sum up the conversions and decimate them to ADC_EXTRA_BITS more bits
+    uint16_t sum = 0;
+    for (uint8_t n = 0; n < ADC_SAMPLES; n++) {
+      sum += analogRead(pinList[i]);
+    }
+    int value = sum >> ADC_EXTRA_BITS;
+
     if (invertList[i] == 1) {
       // invert the reading
-      rawReads[i] = 1023 - analogRead(pinList[i]);
+      rawReads[i] = ADC_MAXVAL - value;
     } else {
-      rawReads[i] = analogRead(pinList[i]);
+      rawReads[i] = value;
     }
   }
+  return true;
+#endif
+}
+
+/**--- Scaling of the centered values
+// FilterAnalogReadOuts() maps every channel from [deadzone, max] to [0, 350] (or [min, -deadzone] to [-350, 0]).
+// Arduino's map() calculates (x - in_min) * 350 / (in_max - in_min) with a 32 bit division, eight times per loop.
+// Instead, a factor 350 * 2^16 / range is calculated for every channel and direction, when the parameters
+// have been changed (updateKinematicTables()). Scaling is then one multiplication and a shift:
+//
+// 1. the factor is rounded up, so the shifted product is the exact result or one too large.
+//    One more multiplication detects and corrects this, so the results are exactly the ones of map().
+// 2. for small ranges (< SCALE_MIN_RANGE) or large inputs (>= SCALE_MAX_INPUT), the product wouldn't fit into
+//    32 bit or the error of the factor would be too large: map() is used for those.
+*/
+#define SCALE_MIN_RANGE 64
+#define SCALE_MAX_INPUT 8192
+
+typedef struct _ChannelScale {
+  uint32_t factor; // TOTALSENSITIVITY * 2^16 / range, rounded up. 0 = use map()
+  uint16_t range;  // in_max - in_min of map()
+} ChannelScale;
+
+static ChannelScale scaleNeg[8];   // [min, -deadzone] -> [-350, 0]
+static ChannelScale scalePos[8];   // [deadzone, max]  -> [0, 350]
+
+/// @brief Calculate the factor for one channel and direction
+static void buildChannelScale(ChannelScale& scale, long range) {
+  if (range >= SCALE_MIN_RANGE && range <= 65535L) {
+    scale.range = range;
+    scale.factor = (((uint32_t)TOTALSENSITIVITY << 16) + range - 1) / range;
+  } else {
+    scale.factor = 0;
+  }
+}
+
+/// @brief Calculate value * TOTALSENSITIVITY / range, rounded down, with the factor
+/// @param value input, 0 ... SCALE_MAX_INPUT - 1
+static uint16_t applyChannelScale(uint16_t value, const ChannelScale& scale) {
+  uint16_t result = ((uint32_t)value * scale.factor) >> 16;
+  // the factor was rounded up, so the result might be one too large
+  if ((uint32_t)result * scale.range > (uint32_t)value * TOTALSENSITIVITY) {
+    result--;
+  }
+  return result;
 }
 
 /// @brief Takes the centered joystick values, applies a deadzone and maps the values to +/- 350.
 /// @param centered pointer to array with 8 centered analog values
 void FilterAnalogReadOuts(int *centered, ParamData& par){
-  // set the min and maxvals from the config.h into real variables
-  static int minVals[8] = MINVALS;
-  static int maxVals[8] = MAXVALS;
+  // the min and maxvals are parameters, initialized from the config.h
+  int16_t* minVals = par.values->minVals;
+  int16_t* maxVals = par.values->maxVals;
+
+  // MINVALS, MAXVALS and DEADZONE are given in 10 bit ADC values, scale them to the oversampled values
+  int deadzone = par.values->deadzone * ADC_SCALE;
 
     // Filter movement values. Set to zero if movement is below deadzone threshold.
   for(int i = 0; i < 8; i++){
-    if (centered[i] < par.values->deadzone && centered[i] > -par.values->deadzone){
+    if (centered[i] < deadzone && centered[i] > -deadzone){
             centered[i] = 0;
     }else{
       if(centered[i] < 0){ // if the value is smaller 0 ...
         // ... map the value from the [min,-DEADZONE] to [-350,0]
-        centered[i] = map(centered[i], minVals[i], -par.values->deadzone, -TOTALSENSITIVITY, 0);
+        long value = centered[i] - (long)minVals[i] * ADC_SCALE;
+        if (scaleNeg[i].factor != 0 && abs(value) < SCALE_MAX_INPUT) {
+          // map() truncates towards zero, also for values below min
+          int scaled = applyChannelScale(abs(value), scaleNeg[i]);
+          centered[i] = ((value < 0) ? -scaled : scaled) - TOTALSENSITIVITY;
+        } else {
+          centered[i] = map(centered[i], (long)minVals[i] * ADC_SCALE, -deadzone, -TOTALSENSITIVITY, 0);
+        }
       }else{ // if the value is > 0 ...
         // ... map the values from the [DEADZONE,max] to [0,+350]
-        centered[i] = map(centered[i], par.values->deadzone, maxVals[i], 0, TOTALSENSITIVITY);
+        long value = centered[i] - (long)deadzone;
+        if (scalePos[i].factor != 0 && value >= 0 && value < SCALE_MAX_INPUT) {
+          centered[i] = applyChannelScale(value, scalePos[i]);
+        } else {
+          centered[i] = map(centered[i], deadzone, (long)maxVals[i] * ADC_SCALE, 0, TOTALSENSITIVITY);
+        }
       }
     }
   }
@@ -137,7 +300,19 @@ void FilterAnalogReadOuts(int *centered, ParamData& par){
  *
  */
 
-void _calculateKinematicSensors(int* centered, int16_t* velocity, bool prio_z_exclusive){
+/**
+ * The equations above are stored as mixing matrix MIX in the parameters (see parameterMenu.h), so other
+ * sensor geometries or corrections of cross-talk between the sensors are just a change of the parameters:
+ *
+ *   velocity[row] = (sum over col of MIX[row * 8 + col] * centered[col]) / 2^MIX_SHIFT[row]
+ *
+ * The division truncates towards zero, like the integer division of the former hardcoded equations.
+ * Therefore the default matrices for joysticks and hall effect sensors give exactly the same velocities.
+ */
+
+void _calculateKinematicSensors(int* centered, int16_t* velocity, ParamData& par){
+  bool rotationsOff = false;
+
   // resistive joysticks or hall-joysticks
   #ifndef HALLEFFECT
 
@@ -156,42 +331,158 @@ void _calculateKinematicSensors(int* centered, int16_t* velocity, bool prio_z_ex
   if(centered[CX] < 0){cntN += 1;} if(centered[CX] > 0){cntP += 1;}
   if(centered[DX] < 0){cntN += 1;} if(centered[DX] > 0){cntP += 1;}
 
-    bool zMove = ((cntP >= 3 && cntN == 0) || (cntN >= 3 && cntP == 0));
+  bool zMove = ((cntP >= 3 && cntN == 0) || (cntN >= 3 && cntP == 0));
 
-    velocity[TRANSX] = (-centered[CY] +centered[AY]);
-    velocity[TRANSY] = (-centered[BY] +centered[DY]);
-    velocity[TRANSZ] = (-centered[AX] -centered[BX] -centered[CX] -centered[DX]);
+  // if a z-move is detected, make the rotations zero
+  rotationsOff = (par.values->exclusiveMode && zMove);
+  #endif
 
-    if (prio_z_exclusive && zMove) // if a z-move is detected, make the rotations zero
-    {
-      velocity[ROTX] = 0;
-      velocity[ROTY] = 0;
-      velocity[ROTZ] = 0;
+  for (uint8_t row = TRANSX; row <= ROTZ; row++) {
+    if (rotationsOff && row >= ROTX) {
+      velocity[row] = 0;
+      continue;
     }
-    else
-    {
-      velocity[ROTX] = (-centered[CX] + centered[AX]);
-      velocity[ROTY] = (-centered[BX] + centered[DX]);
-      velocity[ROTZ] = (+centered[AY] + centered[BY] + centered[CY] + centered[DY]);
+    // multiply-accumulate one row of the matrix, most coefficients are zero
+    const int8_t* coefficient = &par.values->mixMatrix[row * 8];
+    int32_t sum = 0;
+    for (uint8_t col = 0; col < 8; col++, coefficient++) {
+      if (*coefficient != 0) {
+        sum += (int32_t)*coefficient * centered[col];
+      }
     }
+    // divide by 2^shift, truncated towards zero
+    uint8_t shift = constrain(par.values->mixShift[row], 0, 15);
+    sum = (sum < 0) ? -((-sum) >> shift) : (sum >> shift);
+    velocity[row] = constrain(sum, (int32_t)INT16_MIN, (int32_t)INT16_MAX);
+  }
+}
 
-  // hall-sensors with magnets
-  #else
-    velocity[TRANSX] = (centered[HES1] -centered[HES0] +centered[HES6] -centered[HES7]) / 2;
-    velocity[TRANSY] = (centered[HES2] -centered[HES3] +centered[HES9] -centered[HES8]) / 2;
-    velocity[TRANSZ] = (centered[HES0] +centered[HES1] +centered[HES2] +centered[HES3] +centered[HES6] +centered[HES7] +centered[HES8] +centered[HES9]) / 4;
-    velocity[ROTX]   = (centered[HES0] +centered[HES1] -centered[HES6] -centered[HES7]) / 2;
-    velocity[ROTY]   = (centered[HES8] +centered[HES9] -centered[HES2] -centered[HES3]) / 2;
-    velocity[ROTZ]   = (centered[HES0] +centered[HES2] +centered[HES6] +centered[HES8] -centered[HES1] -centered[HES3] -centered[HES7] -centered[HES9]) / 4;
-  #endif
+// index of the sensitivity for negative transZ, the axes TRANSX ... ROTZ are used for the other sensitivities
+#define FIX_NEG_TRANSZ 6
+
+#ifdef KINEMATICS_FIXEDPOINT
+/**--- Fixed point sensitivities
+// Dividing by the (double) sensitivities costs a soft-float division for every axis in every loop.
+// With KINEMATICS_FIXEDPOINT, the reciprocal of every sensitivity is calculated once, after the parameters
+// have been changed (updateKinematicTables()), as Q22 multiplier: v / sens = (v * (2^22 / sens)) >> 22
+//
+// 1. the multiplier is 2^22 / sens, rounded to the nearest integer. The result is truncated towards zero like the
+//    conversion of the double to int16_t, but it may differ by one from the floating point division, when the
+//    quotient is close to an integer.
+// 2. sensitivities below 0.01 are limited to 0.01, so the multiplier fits in 32 bit
+// 3. inputs, which result in more than TOTALSENSITIVITY, are limited before the multiplication.
+//    So the product always fits in 32 bit and all results are clipped to +/-350 afterwards anyway.
+*/
+typedef struct _FixedSensitivity {
+  double   sensitivity; // the parameter, for which the multiplier was calculated
+  uint32_t factor;      // 2^22 / abs(sensitivity)
+  uint16_t limit;       // abs(input) from which on the result is more than TOTALSENSITIVITY
+  bool     negative;    // sensitivity < 0
+} FixedSensitivity;
+
+static FixedSensitivity fixedSens[7];
+static int16_t          fixedGateNegTransZ; // GATE_NTZ rounded up, to compare integers with the same result
+
+/// @brief Calculate the fixed point multiplier for one sensitivity, if it changed
+static void buildFixedSensitivity(FixedSensitivity& fix, double sensitivity) {
+  if (sensitivity == fix.sensitivity && fix.factor != 0) {
+    return;
+  }
+  fix.sensitivity = sensitivity;
+  fix.negative = (sensitivity < 0);
+  sensitivity = max(fabs(sensitivity), 0.01); // the multiplier would be too large
+  fix.factor = (uint32_t)(4194304.0 / sensitivity + 0.5);
+  // smallest input with a product of (TOTALSENSITIVITY + 1) << 22 or more
+  fix.limit = min((((uint32_t)(TOTALSENSITIVITY + 1) << 22) + fix.factor - 1) / fix.factor, 65535UL);
+}
+
+/// @brief Calculate all fixed point sensitivities from the parameters
+static void buildFixedSensitivities(ParamData& par) {
+  buildFixedSensitivity(fixedSens[TRANSX], par.values->transX_sensitivity);
+  buildFixedSensitivity(fixedSens[TRANSY], par.values->transY_sensitivity);
+  buildFixedSensitivity(fixedSens[TRANSZ], par.values->pos_transZ_sensitivity);
+  buildFixedSensitivity(fixedSens[FIX_NEG_TRANSZ], par.values->neg_transZ_sensitivity);
+  buildFixedSensitivity(fixedSens[ROTX], par.values->rotX_sensitivity);
+  buildFixedSensitivity(fixedSens[ROTY], par.values->rotY_sensitivity);
+  buildFixedSensitivity(fixedSens[ROTZ], par.values->rotZ_sensitivity);
+  fixedGateNegTransZ = (int16_t)ceil(par.values->gate_neg_transZ);
+}
+
+/// @brief Divide the value by the sensitivity with the fixed point multiplier
+/// @param value velocity of the axis
+/// @param fix fixed point sensitivity of the axis
+/// @return value / sensitivity, truncated towards zero (+/-1) and limited to +/-TOTALSENSITIVITY
+static int16_t applyFixedSensitivity(int16_t value, const FixedSensitivity& fix) {
+  bool negative = (value < 0) != fix.negative;
+  uint16_t absValue = abs(value);
+  int16_t result;
+  if (absValue >= fix.limit) {
+    result = TOTALSENSITIVITY;
+  } else {
+    result = (int16_t)(((uint32_t)absValue * fix.factor) >> 22);
+  }
+  return negative ? -result : result;
+}
+#endif
+
+/// @brief Divide the velocity of an axis by its sensitivity
+/// @param value velocity of the axis
+/// @param axis TRANSX ... ROTZ or FIX_NEG_TRANSZ, to select the fixed point sensitivity
+/// @param sensitivity sensitivity from the parameters, for the calculation in floating point
+/// @return value / sensitivity, truncated towards zero
+static inline int16_t divideBySensitivity(int16_t value, uint8_t axis, double sensitivity) {
+#ifdef KINEMATICS_FIXEDPOINT
+  return applyFixedSensitivity(value, fixedSens[axis]);
+#else
+  return (int16_t)(value / sensitivity);
+#endif
+}
+
+/// @brief Rebuild the tables derived from the parameters: the lookup table of the modifier function, the scaling
+/// of the channels and the fixed point sensitivities. This is called by parametersChanged() and once in setup(),
+/// so the kinematics in the loop() never spends the time to build them.
+void updateKinematicTables(ParamData& par) {
+  static bool    tablesValid = false;
+  static uint8_t tablesRevision;
+  if (tablesValid && tablesRevision == par.revision) {
+    return;
+  }
+  tablesValid = true;
+  tablesRevision = par.revision;
+
+  // building the lookup table takes several hundred calls of modifierFunction(), only do it if necessary
+  const ParamStorage *p = par.values;
+  if (!modTableValid || modTableFunc != p->modFunc || modTableA != p->slope_at_zero || modTableB != p->slope_at_end) {
+    buildModifierTable(par);
+    modTableValid = true;
+    modTableFunc = p->modFunc;
+    modTableA = p->slope_at_zero;
+    modTableB = p->slope_at_end;
+  }
+
+  int deadzone = p->deadzone * ADC_SCALE;
+  for (int i = 0; i < 8; i++) {
+    buildChannelScale(scaleNeg[i], -deadzone - (long)p->minVals[i] * ADC_SCALE);
+    buildChannelScale(scalePos[i], (long)p->maxVals[i] * ADC_SCALE - deadzone);
+  }
+
+#ifdef KINEMATICS_FIXEDPOINT
+  buildFixedSensitivities(par);
+#endif
 }
 
 /// @brief Calculate the kinematic of the three axis from the eight joysticks
 /// @param centered eight values from the four joysticks or eight hall-sensors
 /// @param velocity resulting translational and rotational motions
 void calculateKinematic(int *centered, int16_t *velocity, ParamData& par){
+#ifdef KINEMATICS_FIXEDPOINT
+  int16_t gateNegTransZ = fixedGateNegTransZ;
+#else
+  double gateNegTransZ = par.values->gate_neg_transZ;
+#endif
+
   // Get raw kinematics from sensors
-  _calculateKinematicSensors(centered, velocity, par.values->exclusiveMode);
+  _calculateKinematicSensors(centered, velocity, par);
 
   // Invert directions if needed. Done first so the direction-dependand factors modify the right direction.
   if(par.values->invX  == 1){velocity[TRANSX] = -velocity[TRANSX];}
@@ -202,42 +493,42 @@ void calculateKinematic(int *centered, int16_t *velocity, ParamData& par){
   if(par.values->invRZ == 1){velocity[ROTZ]   = -velocity[ROTZ];}
 
   // transX
-  velocity[TRANSX] = velocity[TRANSX] / par.values->transX_sensitivity;
-  velocity[TRANSX] = modifierFunction(velocity[TRANSX], par);                             // recalculate with modifier function
+  velocity[TRANSX] = divideBySensitivity(velocity[TRANSX], TRANSX, par.values->transX_sensitivity);
+  velocity[TRANSX] = modifierTable(velocity[TRANSX], par);                             // recalculate with modifier function
 
   // transY
-  velocity[TRANSY] = velocity[TRANSY] / par.values->transY_sensitivity;
-  velocity[TRANSY] = modifierFunction(velocity[TRANSY], par);                             // recalculate with modifier function
+  velocity[TRANSY] = divideBySensitivity(velocity[TRANSY], TRANSY, par.values->transY_sensitivity);
+  velocity[TRANSY] = modifierTable(velocity[TRANSY], par);                             // recalculate with modifier function
 
   // transZ
   if(velocity[TRANSZ] < 0){
-    velocity[TRANSZ] = velocity[TRANSZ] / par.values->neg_transZ_sensitivity;
-    velocity[TRANSZ] = modifierFunction(velocity[TRANSZ], par);                           // recalculate with modifier function
-    if (abs(velocity[TRANSZ]) < par.values->gate_neg_transZ){
+    velocity[TRANSZ] = divideBySensitivity(velocity[TRANSZ], FIX_NEG_TRANSZ, par.values->neg_transZ_sensitivity);
+    velocity[TRANSZ] = modifierTable(velocity[TRANSZ], par);                           // recalculate with modifier function
+    if (abs(velocity[TRANSZ]) < gateNegTransZ){
       velocity[TRANSZ] = 0;
     }
   }else{                                                                                  // pulling the knob upwards is much heavier... smaller factor
-    velocity[TRANSZ] = velocity[TRANSZ] / par.values->pos_transZ_sensitivity;
-    velocity[TRANSZ] = constrain(velocity[TRANSZ], (double)-TOTALSENSITIVITY, (double)TOTALSENSITIVITY);  // no modifier function, just constrain linear!
+    velocity[TRANSZ] = divideBySensitivity(velocity[TRANSZ], TRANSZ, par.values->pos_transZ_sensitivity);
+    velocity[TRANSZ] = constrain(velocity[TRANSZ], -TOTALSENSITIVITY, TOTALSENSITIVITY);  // no modifier function, just constrain linear!
   }
 
   // rotX
-  velocity[ROTX] = velocity[ROTX] / par.values->rotX_sensitivity;
-  velocity[ROTX] = modifierFunction(velocity[ROTX], par);                                 // recalculate with modifier function
+  velocity[ROTX] = divideBySensitivity(velocity[ROTX], ROTX, par.values->rotX_sensitivity);
+  velocity[ROTX] = modifierTable(velocity[ROTX], par);                                 // recalculate with modifier function
   if(abs(velocity[ROTX]) < par.values->gate_rotX){
     velocity[ROTX] = 0;
   }
 
   // rotY
-  velocity[ROTY] = velocity[ROTY] / par.values->rotY_sensitivity;
-  velocity[ROTY] = modifierFunction(velocity[ROTY], par); // recalculate with modifier function
+  velocity[ROTY] = divideBySensitivity(velocity[ROTY], ROTY, par.values->rotY_sensitivity);
+  velocity[ROTY] = modifierTable(velocity[ROTY], par); // recalculate with modifier function
   if(abs(velocity[ROTY]) < par.values->gate_rotY){
     velocity[ROTY] = 0;
   }
 
   // rotZ
-  velocity[ROTZ] = velocity[ROTZ] / par.values->rotZ_sensitivity;
-  velocity[ROTZ] = modifierFunction(velocity[ROTZ], par); // recalculate with modifier function
+  velocity[ROTZ] = divideBySensitivity(velocity[ROTZ], ROTZ, par.values->rotZ_sensitivity);
+  velocity[ROTZ] = modifierTable(velocity[ROTZ], par); // recalculate with modifier function
   if(abs(velocity[ROTZ]) < par.values->gate_rotZ){
     velocity[ROTZ] = 0;
   }
@@ -4,17 +4,32 @@
 #include "parameterMenu.h"
 
 int modifierFunction(int x, ParamData& par);
+int modifierTable(int x, ParamData& par);
 
-void readAllFromJoystick(int *rawReads);
+bool readAllFromJoystick(int *rawReads, bool waitForNewFrame);
 
 void FilterAnalogReadOuts(int* centered, ParamData& par);
 
 void calculateKinematic(int* centered, int16_t* velocity, ParamData& par);
+void updateKinematicTables(ParamData& par);
 
 void switchXY(int16_t *velocity);
 void switchYZ(int16_t *velocity);
 void exclusiveMode(int16_t *velocity, int16_t hysteresis);
 
+// Resolution of the analog values. With ADC_OVERSAMPLING 4 (or 16) in config.h, four (or sixteen)
+// conversions are summed up and shifted right by one (or two) bits, giving 11 (or 12) bit values.
+#if ADC_OVERSAMPLING == 16
+  #define ADC_EXTRA_BITS 2
+#elif ADC_OVERSAMPLING == 4
+  #define ADC_EXTRA_BITS 1
+#else
+  #define ADC_EXTRA_BITS 0
+#endif
+#define ADC_SAMPLES (1 << (2 * ADC_EXTRA_BITS))  // conversions per value
+#define ADC_SCALE   (1 << ADC_EXTRA_BITS)        // factor between 10 bit values (config.h) and rawReads
+#define ADC_MAXVAL  (1023 * ADC_SCALE)           // maximum value of rawReads
+
 // The following constants are here for more readable access to the arrays. You don't need to change this values!
 // Axes in centered or rawValues array
 #define AX 0
@@ -3,6 +3,7 @@
 #include <Arduino.h>
 #include <EEPROM.h>
 #include "parameterMenu.h"
+#include "kinematics.h"
 
 /* possible commands in ProgMode:
 
@@ -12,6 +13,7 @@
   >r      read value                      <r...   (<value> or PE_INVALID_PARAM
   >w...   write value                     <w...   (PE_OK,PE_INVALID_PARAM,PE_INVALID_VALUE "not in
   [-10000..+10000]")
+                                                  (PE_INVALID_VALUE "byte not in [-128..127]")
 
   >l      load params from EEPROM         <l0     (PE_OK)
 
@@ -25,9 +27,14 @@
 
   >i   invalidate magic number <i0   (PE_OK)
 
-  >t   get type of parameter   <t...   (<type>:  1=bool,2=int,3=float or PE_INVALID_PARAM)
+  >t   get type of parameter   <t...   (<type>:  1=bool,2=int,3=float,4=byte or PE_INVALID_PARAM)
 
   >d   get description of parameter    <d...   (<name of  parameter> or PE_INVALID_PARAM)
+
+  >a   get number of array parameters  <a...   (<number of array params>)
+
+  The elements of the array parameters are numbered from ARRAY_PARAM_BASE on, see parameterMenu.h:
+  e.g. >p102 selects the third element of the first array.
 */
 
 #if ENABLE_PROGMODE > 0
@@ -151,6 +158,12 @@ int userInput(
         prog.cmd = next;
         Serial.read();
       } //   'i' invalidate magic-number
+      else if (progMode && !cmdDone && next == 'a') {
+        cmdDone = true;
+        valDone = true;
+        prog.cmd = next;
+        Serial.read();
+      } //   'a' get number of array parameters
 #endif
       else if (next == 'q' || next == 27) {
         state = 2;
@@ -218,7 +231,7 @@ void executeProgCommand(ParamData &par) {
 
   if (prog.retval == PE_OK) {
     if (prog.cmd == 'p') {
-      if (prog.value < 1 || prog.value > NUM_PARAMS) {
+      if (getParameterType(prog.value, par) == 0) {
         prog.retval = PE_INVALID_PARAM;
       } else {
         prog.paramNo = prog.value;
@@ -226,11 +239,14 @@ void executeProgCommand(ParamData &par) {
     }
 
     else if (prog.cmd == 't') {
-      prog.retval = par.description[prog.paramNo].type;
+      prog.retval = getParameterType(prog.paramNo, par);
+      if (prog.retval == 0) {
+        prog.retval = PE_INVALID_PARAM;
+      }
     }
 
     else if (prog.cmd == 'd') {
-      if (prog.paramNo < 1 || prog.paramNo > NUM_PARAMS) {
+      if (getParameterType(prog.paramNo, par) == 0) {
         prog.retval = PE_INVALID_PARAM;
       } else {
         Serial.print(F("<d"));
@@ -241,19 +257,22 @@ void executeProgCommand(ParamData &par) {
     }
 
     else if (prog.cmd == 'r') {
-      if (prog.paramNo < 1 || prog.paramNo > NUM_PARAMS) {
+      if (getParameterType(prog.paramNo, par) == 0) {
         prog.retval = PE_INVALID_PARAM;
       } else {
         prog.retval = readParameter(prog.paramNo, par);
-        intVal = (par.description[prog.paramNo].type != PARAM_TYPE_FLOAT);
+        intVal = (getParameterType(prog.paramNo, par) != PARAM_TYPE_FLOAT);
       }
     }
 
     else if (prog.cmd == 'w') {
-      if (prog.paramNo < 1 || prog.paramNo > NUM_PARAMS) {
+      if (getParameterType(prog.paramNo, par) == 0) {
         prog.retval = PE_INVALID_VALUE;
       } else if (prog.value < -10000.0 || prog.value > +10000.0) {
         prog.retval = PE_INVALID_PARAM;
+      } else if (getParameterType(prog.paramNo, par) == PARAM_TYPE_BYTE &&
+                 (prog.value < -128.0 || prog.value > 127.0)) {
+        prog.retval = PE_INVALID_VALUE; // doesn't fit in int8_t
       } else {
         writeParameter(prog.paramNo, prog.value, par);
       }
@@ -284,6 +303,10 @@ void executeProgCommand(ParamData &par) {
       prog.retval = NUM_PARAMS;
     }
 
+    else if (prog.cmd == 'a') {
+      prog.retval = NUM_ARRAY_PARAMS;
+    }
+
     else if (prog.cmd == 'i') {
       EEPROM.put(BASE_ADDRESS_MAGIC, invalidNum);
     }
@@ -387,6 +410,10 @@ int parameterMenu(ParamData &par) {
         Serial.print("#define ");
         printOneParameter(i, par, true, false);
       }
+      for (int a = 0; a < NUM_ARRAY_PARAMS; a++) {
+        Serial.print("#define ");
+        printArrayParameter(a, par, false);
+      }
       state = 1; // writeMenu
       break;
 
@@ -440,7 +467,7 @@ int editParameters(ParamData &par) {
   }
 
   if (state == 3) { // show actual parameter value
-    if (parIndex >= 1 && parIndex <= NUM_PARAMS) {
+    if (getParameterType(parIndex, par) != 0) {
       isFloat = printOneParameter(parIndex, par, false, true);
       Serial.print(F(" -> "));
       state = 4; // input parameter value
@@ -472,6 +499,61 @@ int editParameters(ParamData &par) {
   return state;
 }
 
+/// @brief  checks, if the parameter number i is an element of an array parameter
+/// @param  i          parameter number
+/// @param  par        struct of parameters used by the system at runtime
+/// @param  a          (output) index of the array parameter
+/// @param  e          (output) index of the element within the array
+/// @return true, if i is a valid element of an array parameter
+static bool getArrayElement(int i, ParamData &par, int &a, int &e) {
+  if (i < ARRAY_PARAM_BASE) {
+    return false;
+  }
+  a = (i - ARRAY_PARAM_BASE) / ARRAY_PARAM_STRIDE;
+  e = (i - ARRAY_PARAM_BASE) % ARRAY_PARAM_STRIDE;
+  return (a < NUM_ARRAY_PARAMS && e < par.arrays[a].count);
+}
+
+/// @brief  gets the storage of a parameter or an element of an array parameter
+/// @param  i          parameter number
+/// @param  par        struct of parameters used by the system at runtime
+/// @param  type       (output) type of the parameter
+/// @return pointer to the value or NULL, if there is no parameter with this number
+static void *getParameterStorage(int i, ParamData &par, int &type) {
+  int a, e;
+
+  if (i >= 1 && i <= NUM_PARAMS) {
+    type = par.description[i].type;
+    return par.description[i].storage;
+  } else if (getArrayElement(i, par, a, e)) {
+    type = par.arrays[a].type;
+    if (type == PARAM_TYPE_INT) {
+      return (int16_t *)par.arrays[a].storage + e;
+    } else {
+      return (int8_t *)par.arrays[a].storage + e;
+    }
+  }
+  type = 0;
+  return NULL;
+}
+
+/// @brief  gets the type of a parameter or an element of an array parameter
+/// @param  i          parameter number
+/// @param  par        struct of parameters used by the system at runtime
+/// @return PARAM_TYPE_... or 0, if there is no parameter with this number
+int getParameterType(int i, ParamData &par) {
+  int type;
+  getParameterStorage(i, par, type);
+  return type;
+}
+
+/// @brief  the values of the parameters have been changed: rebuild everything, which is derived from them
+/// @param  par        struct of parameters used by the system at runtime
+void parametersChanged(ParamData &par) {
+  par.revision++;
+  updateKinematicTables(par);
+}
+
 /// @brief  gets all parameters from EEPROM, if the magic number in EEPROM is correct
 /// @param  par        struct of parameters used by the system at runtime, read from EEPROM
 void getParametersFromEEPROM(ParamData &par) {
@@ -479,6 +561,7 @@ void getParametersFromEEPROM(ParamData &par) {
   EEPROM.get(BASE_ADDRESS_MAGIC, magicNumber);
   if (magicNumber == MAGIC_NUMBER) {
     EEPROM.get(BASE_ADDRESS_PAR, *par.values);
+    parametersChanged(par);
   } else {
     Serial.println(F("Wrong magic!")); // No params in EEPROM are assumed
   }
@@ -498,11 +581,23 @@ void putParametersToEEPROM(ParamData &par) {
 /// @param  formatted  true=print name left aligned, false=print only name
 /// @return nothing
 void printParameterName(int i, ParamData &par, bool formatted) {
-
-  Serial.print(par.description[i].name);
+  int a, e;
+  int len;
+
+  if (getArrayElement(i, par, a, e)) {
+    // element of an array parameter: NAME[e]
+    Serial.print(par.arrays[a].name);
+    Serial.print("[");
+    Serial.print(e);
+    Serial.print("]");
+    len = strlen(par.arrays[a].name) + (e <= 9 ? 3 : 4);
+  } else {
+    Serial.print(par.description[i].name);
+    len = strlen(par.description[i].name);
+  }
 
   if (formatted) {
-    int c = MAX_PARAM_NAME_LEN - strlen(par.description[i].name);
+    int c = max(MAX_PARAM_NAME_LEN - len, 0);
     char spc[MAX_PARAM_NAME_LEN + 1];
 
     for (int n = 0; n < c; n++) {
@@ -520,6 +615,31 @@ void printAllParameters(ParamData &par, bool num) {
   for (int i = 1; i <= NUM_PARAMS; i++) {
     printOneParameter(i, par, true, num);
   }
+  for (int a = 0; a < NUM_ARRAY_PARAMS; a++) {
+    printArrayParameter(a, par, num);
+  }
+}
+
+/// @brief  prints all elements of an array parameter in one line to Serial, like {1, 2, 3}
+/// @param  a          index of the array parameter
+/// @param  par        struct of parameters used by the system at runtime
+/// @param  numbering  true=numbers the line with the parameter number of the first element
+void printArrayParameter(int a, ParamData &par, bool numbering) {
+  int first = ARRAY_PARAM_BASE + a * ARRAY_PARAM_STRIDE;
+
+  if (numbering) {
+    Serial.print(first);
+    Serial.print(" ");
+  }
+  Serial.print(par.arrays[a].name);
+  Serial.print(" {");
+  for (int e = 0; e < par.arrays[a].count; e++) {
+    if (e > 0) {
+      Serial.print(", ");
+    }
+    Serial.print((int)readParameter(first + e, par));
+  }
+  Serial.println("}");
 }
 
 /// @brief  prints one parameter with its name to Serial
@@ -530,9 +650,10 @@ void printAllParameters(ParamData &par, bool num) {
 /// @return isFloat    true=selected parameter is a double; false=selected parameter is an integer
 bool printOneParameter(int i, ParamData &par, bool line, bool numbering) {
   bool isFloat = false;
+  int type = getParameterType(i, par);
 
-  if (i >= 1 && i <= NUM_PARAMS) {
-    isFloat = (par.description[i].type == PARAM_TYPE_FLOAT);
+  if (type != 0) {
+    isFloat = (type == PARAM_TYPE_FLOAT);
 
     if (numbering) {
       if (i <= 9) {
@@ -563,17 +684,20 @@ bool printOneParameter(int i, ParamData &par, bool line, bool numbering) {
 /// @return value     read from the selected parameter
 double readParameter(int i, ParamData &par) {
   double value = NAN;
+  int type;
+  void *storage = getParameterStorage(i, par, type);
 
-  if (i >= 1 && i <= NUM_PARAMS) {
-    switch (par.description[i].type) {
+  if (storage != NULL) {
+    switch (type) {
     case PARAM_TYPE_BOOL:
-      value = *(int8_t *)par.description[i].storage;
+    case PARAM_TYPE_BYTE:
+      value = *(int8_t *)storage;
       break;
     case PARAM_TYPE_INT:
-      value = *(int16_t *)par.description[i].storage;
+      value = *(int16_t *)storage;
       break;
     case PARAM_TYPE_FLOAT:
-      value = *(double *)par.description[i].storage;
+      value = *(double *)storage;
       break;
     }
   }
@@ -586,17 +710,22 @@ double readParameter(int i, ParamData &par) {
 /// @param  value     value to write into the selected parameter
 /// @param  par       struct of parameters used by the system at runtime
 void writeParameter(int i, double value, ParamData &par) {
-  if (i >= 1 && i <= NUM_PARAMS) {
-    switch (par.description[i].type) {
+  int type;
+  void *storage = getParameterStorage(i, par, type);
+
+  if (storage != NULL) {
+    switch (type) {
     case PARAM_TYPE_BOOL:
-      *((int8_t *)par.description[i].storage) = (int8_t)trunc(value);
+    case PARAM_TYPE_BYTE:
+      *((int8_t *)storage) = (int8_t)trunc(constrain(value, -128.0, 127.0));
       break;
     case PARAM_TYPE_INT:
-      *((int16_t *)par.description[i].storage) = (int16_t)trunc(value);
+      *((int16_t *)storage) = (int16_t)trunc(value);
       break;
     case PARAM_TYPE_FLOAT:
-      *((double *)par.description[i].storage) = value;
+      *((double *)storage) = value;
       break;
     }
+    parametersChanged(par);
   }
 }
@@ -31,19 +31,91 @@
   // 10. check the parameters with "list parameters"
   // 11. modify the parameters as needed with "edit parameters"
   // 12. store the parameters to the EEPROM with "write to EEPROM"
+  //
+  // to define a new array parameter (a table of integers, like the mixing matrix):
+  // ---------------------------------------------------------------------------
+  // - insert the array into the struct ParamStorage and increment NUM_ARRAY_PARAMS
+  // - insert a line into the initialization of par.arrays in spacemouse-keys.ino, e.g.
+  //    {PARAM_TYPE_BYTE, "MIX",            parStorage.mixMatrix, 48}, //      100 ... 147
+  //     ^type of the elements ^name        ^pointer to the array ^number of elements
+  // - the elements get the parameter numbers ARRAY_PARAM_BASE + ARRAY_PARAM_STRIDE * (array index)
+  //   + (element index), so the first array starts at 100, the second one at 200, ...
+  // - only PARAM_TYPE_BYTE (int8_t) and PARAM_TYPE_INT (int16_t) are supported for arrays
   //---------------------------------------------------------
 
-  #define NUM_PARAMS         33   // total number of parameters in struct ParamStorage
+  #define NUM_PARAMS         35   // total number of parameters in struct ParamStorage
+  #ifdef KEYMAP
+    #define NUM_ARRAY_PARAMS 9    // total number of array parameters in struct ParamStorage
+  #else
+    #define NUM_ARRAY_PARAMS 4    // total number of array parameters in struct ParamStorage
+  #endif
+  #define ARRAY_PARAM_BASE   100  // parameter number of the first element of the first array
+  #define ARRAY_PARAM_STRIDE 100  // distance between the parameter numbers of two arrays
 
   #define MAX_PARAM_NAME_LEN 10   // maximum length of any parameter name
 
-  #define MAGIC_NUMBER       1209196405L
+  #ifdef KEYMAP
+    // the size of the tables of the key map depends on NUMKEYS and KEYMAP_CHORDS
+    #define MAGIC_NUMBER     (1263488331L + 64L * NUMKEYS + KEYMAP_CHORDS)
+  #else
+    #define MAGIC_NUMBER     1209196408L
+  #endif
   #define BASE_ADDRESS_MAGIC 0
   #define BASE_ADDRESS_PAR   4
 
+  // the center points of the fast start are stored behind the parameters, see fastZeroing() in calibration.cpp
+  // the magic number contains ADC_SCALE, because the center points depend on the oversampling
+  #define CENTER_MAGIC_NUMBER       (1129204820L + ADC_SCALE)
+  #define BASE_ADDRESS_CENTER_MAGIC (BASE_ADDRESS_PAR + sizeof(ParamStorage))
+  #define BASE_ADDRESS_CENTER       (BASE_ADDRESS_CENTER_MAGIC + 4)
+
   #define PARAM_TYPE_BOOL    1
   #define PARAM_TYPE_INT     2
   #define PARAM_TYPE_FLOAT   3
+  #define PARAM_TYPE_BYTE    4
+
+  // Defaults of the HID timing, for config.h files without them, see Advanced HID settings in config_sample.h
+  #ifndef HID_RATE
+    #define HID_RATE  16
+  #endif
+  #ifndef HID_EPINT
+    #define HID_EPINT 0
+  #endif
+
+  // Default mixing matrices for the kinematics, see _calculateKinematicSensors() in kinematics.cpp
+  // Every row calculates one axis (TRANSX, TRANSY, TRANSZ, ROTX, ROTY, ROTZ) from the eight centered
+  // values. The sum of each row is divided by 2^MIX_SHIFT of this row.
+  #ifndef MIX
+    #ifndef HALLEFFECT
+      //     AX  AY  BX  BY  CX  CY  DX  DY
+      #define MIX { 0,  1,  0,  0,  0, -1,  0,  0,  /* TRANSX */ \
+                    0,  0,  0, -1,  0,  0,  0,  1,  /* TRANSY */ \
+                   -1,  0, -1,  0, -1,  0, -1,  0,  /* TRANSZ */ \
+                    1,  0,  0,  0, -1,  0,  0,  0,  /* ROTX   */ \
+                    0,  0, -1,  0,  0,  0,  1,  0,  /* ROTY   */ \
+                    0,  1,  0,  1,  0,  1,  0,  1}  /* ROTZ   */
+      #define MIX_SHIFT {0, 0, 0, 0, 0, 0}
+    #else
+      //    HES0 HES1 HES2 HES3 HES6 HES7 HES8 HES9
+      #define MIX {-1,  1,  0,  0,  1, -1,  0,  0,  /* TRANSX */ \
+                    0,  0,  1, -1,  0,  0, -1,  1,  /* TRANSY */ \
+                    1,  1,  1,  1,  1,  1,  1,  1,  /* TRANSZ */ \
+                    1,  1,  0,  0, -1, -1,  0,  0,  /* ROTX   */ \
+                    0,  0, -1, -1,  0,  0,  1,  1,  /* ROTY   */ \
+                    1, -1,  1, -1,  1, -1,  1, -1}  /* ROTZ   */
+      #define MIX_SHIFT {1, 1, 2, 1, 1, 2}
+    #endif
+  #endif
+
+  // Special values in the tables of the key map, see KEYMAP in config_sample.h
+  #ifdef KEYMAP
+    #ifndef KM_NONE
+      #define KM_NONE  -1  // no button
+    #endif
+    #ifndef KM_LAYER
+      #define KM_LAYER -2  // in KM_TAP: the key switches to the second layer, as long as it is pressed
+    #endif
+  #endif
 
   typedef struct _ParamStorage {
     int16_t deadzone               = DEADZONE;
@@ -86,6 +158,23 @@
 
     int16_t rotAxisEchos           = RAXIS_ECH;
     int16_t rotAxisSimStrength     = RAXIS_STR;    
+
+    int16_t hidRate                = HID_RATE;     // [ms] 1, 2, 4, 8 or 16
+    int16_t hidEpInterval          = HID_EPINT;    // [ms] 1, 2, 4, 8, 16 or 0 (as before)
+
+    int8_t  mixMatrix[6 * 8]       = MIX;          // array parameter: 6 rows (axes) x 8 columns (centered values)
+    int8_t  mixShift[6]            = MIX_SHIFT;    // array parameter: right shift of each row
+
+    int16_t minVals[8]             = MINVALS;      // array parameter: minimum centered values (10 bit)
+    int16_t maxVals[8]             = MAXVALS;      // array parameter: maximum centered values (10 bit)
+
+  #ifdef KEYMAP
+    int8_t  kmTap[2 * NUMKEYS]     = KM_TAP;       // array parameter: button of a short press, layer 0 and 1
+    int8_t  kmHold[2 * NUMKEYS]    = KM_HOLD;      // array parameter: button of a long press, layer 0 and 1
+    int8_t  kmDouble[NUMKEYS]      = KM_DOUBLE;    // array parameter: button of a double tap
+    int8_t  kmChord[3 * KEYMAP_CHORDS] = KM_CHORD; // array parameter: two keys and their button
+    int16_t kmTimes[3]             = KM_TIMES;     // array parameter: [ms] long press, double tap, chord
+  #endif
   } ParamStorage;
 
   typedef struct _ParamDescription {
@@ -94,9 +183,18 @@
     void* storage;
   } ParamDescription;
 
+  typedef struct _ParamArrayDescription {
+    int     type;
+    char    name[MAX_PARAM_NAME_LEN+1];
+    void*   storage;
+    uint8_t count;
+  } ParamArrayDescription;
+
   typedef struct _ParamData {
-    ParamStorage*     values;
-    ParamDescription  description[NUM_PARAMS+1];
+    ParamStorage*          values;
+    ParamDescription       description[NUM_PARAMS+1];
+    ParamArrayDescription  arrays[NUM_ARRAY_PARAMS];
+    uint8_t           revision;  // incremented on every change of the values, to rebuild tables derived from them
   } ParamData;
 
   #if ENABLE_PROGMODE > 0
@@ -115,13 +213,16 @@
   #endif
 
   int    userInput(double& value);
+  int    getParameterType(int i, ParamData& par);
   double readParameter(int i, ParamData& par);
   void   writeParameter(int i, double value, ParamData& par);
   void   getParametersFromEEPROM(ParamData& par);
+  void   parametersChanged(ParamData& par);
   void   putParametersToEEPROM(ParamData& par);
   void   printParameterName(int i, ParamData& par, bool formatted);
   bool   printOneParameter(int i, ParamData& par, bool line, bool num);
   void   printAllParameters(ParamData& par, bool num);
+  void   printArrayParameter(int a, ParamData& par, bool num);
   int    editParameters(ParamData& par);
   int    parameterMenu(ParamData& par);
   #if ENABLE_PROGMODE > 0
@@ -3,59 +3,368 @@
 // it as config.h
 #include "config.h"
 #include <Arduino.h>
+#include "spaceKeys.h"
+
+// time in ms between two samples of the keys for the debouncing, see evalKeys()
+#ifndef DEBOUNCE_SAMPLE_MS
+#define DEBOUNCE_SAMPLE_MS 5
+#endif
+
 // check config.h if this functions and variables are needed
 #if NUMKEYS > 0
 
-// array with the pin definition of all keys
-int keyList[NUMKEYS] = KEYLIST;
+// array with the pin definition of all keys, which are wired directly to a pin
+constexpr int keyList[NUMDIRECTKEYS] = KEYLIST;
+
+// The keys are debounced bit-parallel: every key is one bit in a bitmap
+#if NUMKEYS <= 8
+typedef uint8_t keyBits_t;
+#elif NUMKEYS <= 16
+typedef uint16_t keyBits_t;
+#elif NUMKEYS <= 32
+typedef uint32_t keyBits_t;
+#else
+#error "The debouncing of the keys supports up to 32 keys"
+#endif
+
+#ifdef KEYS_ISR
+#ifndef __AVR_ATmega32U4__
+#error "KEYS_ISR is only implemented for the ATmega32U4"
+#endif
+static void keyEventsStart();
+#endif
+
+#if NUMMATRIXKEYS > 0
+// The keys of the key matrix are scanned one row per loop: the active row is driven LOW, the other
+// rows are high impedance and the columns are pulled up. A pressed key pulls its column to LOW,
+// when its row is active. After the read, the next row is activated, so the lines have the time of
+// one loop to settle. The keys of the matrix follow the keys of KEYLIST in keyVals.
+constexpr int keyMatrixRows[KEYMATRIX_NUMROWS] = KEYMATRIX_ROWS;
+constexpr int keyMatrixCols[KEYMATRIX_NUMCOLS] = KEYMATRIX_COLS;
 
-// Function to setup up all keys in keyList
+static uint16_t matrixScan[KEYMATRIX_NUMROWS]; // raw columns of every row, 1 = pressed
+static uint16_t matrixKeys[KEYMATRIX_NUMROWS]; // columns of every row without ghost keys
+static uint8_t matrixRow = 0;                  // the active row
+
+static void setupKeyMatrix() {
+  for (int c = 0; c < KEYMATRIX_NUMCOLS; c++) {
+    pinMode(keyMatrixCols[c], INPUT_PULLUP);
+  }
+  for (int r = 0; r < KEYMATRIX_NUMROWS; r++) {
+    pinMode(keyMatrixRows[r], INPUT);
+  }
+  pinMode(keyMatrixRows[0], OUTPUT);
+  digitalWrite(keyMatrixRows[0], LOW);
+}
+
+#ifndef KEYMATRIX_DIODES
+// Without diodes, three pressed keys in the corners of a rectangle also connect the fourth corner:
+// a ghost key. Such a rectangle is found, if two rows share at least two pressed columns. Then
+// these columns of both rows are ambiguous and keep their last state.
+static void removeGhostKeys() {
+  uint16_t ghosts[KEYMATRIX_NUMROWS] = {0};
+  for (int r1 = 0; r1 < KEYMATRIX_NUMROWS; r1++) {
+    for (int r2 = r1 + 1; r2 < KEYMATRIX_NUMROWS; r2++) {
+      uint16_t common = matrixScan[r1] & matrixScan[r2];
+      if (common & (common - 1)) { // more than one bit set
+        ghosts[r1] |= common;
+        ghosts[r2] |= common;
+      }
+    }
+  }
+  for (int r = 0; r < KEYMATRIX_NUMROWS; r++) {
+    matrixKeys[r] = (matrixScan[r] & ~ghosts[r]) | (matrixKeys[r] & ghosts[r]);
+  }
+}
+#endif
+
+// Read the active row of the key matrix and activate the next row. After the last row, the keys
+// of the whole matrix are taken over into keyVals (LOW = pressed, like the keys with pull up).
+static void scanKeyMatrix(int *keyVals) {
+  uint16_t cols = 0;
+  for (int c = 0; c < KEYMATRIX_NUMCOLS; c++) {
+    if (digitalRead(keyMatrixCols[c]) == LOW) {
+      cols |= (uint16_t)1 << c;
+    }
+  }
+  matrixScan[matrixRow] = cols;
+
+  pinMode(keyMatrixRows[matrixRow], INPUT);
+  if (++matrixRow >= KEYMATRIX_NUMROWS) {
+    matrixRow = 0;
+#ifdef KEYMATRIX_DIODES
+    for (int r = 0; r < KEYMATRIX_NUMROWS; r++) {
+      matrixKeys[r] = matrixScan[r];
+    }
+#else
+    removeGhostKeys();
+#endif
+  }
+  pinMode(keyMatrixRows[matrixRow], OUTPUT);
+  digitalWrite(keyMatrixRows[matrixRow], LOW);
+
+  for (int r = 0; r < KEYMATRIX_NUMROWS; r++) {
+    for (int c = 0; c < KEYMATRIX_NUMCOLS; c++) {
+      keyVals[r * KEYMATRIX_NUMCOLS + c] = (matrixKeys[r] & ((uint16_t)1 << c)) ? LOW : HIGH;
+    }
+  }
+}
+#endif
+
+// Function to setup up all keys in keyList and the key matrix
 void setupKeys() {
-  for (int i = 0; i < NUMKEYS; i++) {
+  for (int i = 0; i < NUMDIRECTKEYS; i++) {
     pinMode(keyList[i], INPUT_PULLUP);
   }
+#if NUMMATRIXKEYS > 0
+  setupKeyMatrix();
+#endif
+#ifdef KEYS_ISR
+  keyEventsStart();
+#endif
+}
+
+#ifdef __AVR_ATmega32U4__
+// The keys are read directly from the port registers: the port and the bit of every pin in KEYLIST
+// are resolved at compile time and every port with keys is read once per loop. digitalRead() looks
+// up the port, the bit and the timer of the pin in every call.
+
+// ports of the ATmega32U4
+#define KEYPORT_B 0
+#define KEYPORT_C 1
+#define KEYPORT_D 2
+#define KEYPORT_E 3
+#define KEYPORT_F 4
+#define KEYPORTS  5
+
+// port and bit of the digital pins 0..30 of the ATmega32U4 (Leonardo, Micro, Pro Micro), see
+// digital_pin_to_port_PGM and digital_pin_to_bit_mask_PGM in pins_arduino.h of the leonardo variant
+constexpr uint8_t pinPort[] = {
+    KEYPORT_D, KEYPORT_D, KEYPORT_D, KEYPORT_D, KEYPORT_D, KEYPORT_C, KEYPORT_D, KEYPORT_E, // D0..D7
+    KEYPORT_B, KEYPORT_B, KEYPORT_B, KEYPORT_B, KEYPORT_D, KEYPORT_C, KEYPORT_B, KEYPORT_B, // D8..D15
+    KEYPORT_B, KEYPORT_B, KEYPORT_F, KEYPORT_F, KEYPORT_F, KEYPORT_F, KEYPORT_F, KEYPORT_F, // D16..D23
+    KEYPORT_D, KEYPORT_D, KEYPORT_B, KEYPORT_B, KEYPORT_B, KEYPORT_D, KEYPORT_D};           // D24..D30
+constexpr uint8_t pinBit[] = {
+    2, 3, 1, 0, 4, 6, 7, 6, // D0..D7
+    4, 5, 6, 7, 6, 7, 3, 1, // D8..D15
+    2, 0, 7, 6, 5, 4, 1, 0, // D16..D23
+    4, 7, 4, 5, 6, 6, 5};   // D24..D30
+
+constexpr bool keyPinsValid(int i = 0) {
+  return (i >= NUMDIRECTKEYS) ? true
+                              : (keyList[i] >= 0 && keyList[i] < (int)sizeof(pinPort) && keyPinsValid(i + 1));
+}
+static_assert(keyPinsValid(), "KEYLIST contains a pin, which is no digital pin of the ATmega32U4");
+
+// bit mask of the keys on a port
+constexpr uint8_t keyPortMask(uint8_t port, int i = 0) {
+  return (i >= NUMDIRECTKEYS) ? 0
+                              : (((pinPort[keyList[i]] == port) ? (1 << pinBit[keyList[i]]) : 0) |
+                                 keyPortMask(port, i + 1));
+}
+
+// scatter the bits of the ports into keyVals, unrolled at compile time from the last key to the first
+template <int I> struct KeyScatter {
+  static inline void read(const uint8_t *ports, int *keyVals) {
+    keyVals[I] = (ports[pinPort[keyList[I]]] >> pinBit[keyList[I]]) & 1;
+    KeyScatter<I - 1>::read(ports, keyVals);
+  }
+};
+template <> struct KeyScatter<-1> {
+  static inline void read(const uint8_t *ports, int *keyVals) {}
+};
+
+// Function to read and store the digital states for each of the keys
+void readAllFromKeys(int *keyVals) {
+  uint8_t ports[KEYPORTS];
+  // only the ports with keys are read, the conditions are resolved at compile time
+  ports[KEYPORT_B] = keyPortMask(KEYPORT_B) ? PINB : 0;
+  ports[KEYPORT_C] = keyPortMask(KEYPORT_C) ? PINC : 0;
+  ports[KEYPORT_D] = keyPortMask(KEYPORT_D) ? PIND : 0;
+  ports[KEYPORT_E] = keyPortMask(KEYPORT_E) ? PINE : 0;
+  ports[KEYPORT_F] = keyPortMask(KEYPORT_F) ? PINF : 0;
+  KeyScatter<NUMDIRECTKEYS - 1>::read(ports, keyVals);
+#if NUMMATRIXKEYS > 0
+  scanKeyMatrix(&keyVals[NUMDIRECTKEYS]);
+#endif
+}
+
+#ifdef KEYS_ISR
+// The keys on port B (pins 8..11 and 14..17) are captured by the pin change interrupt PCINT0: every
+// edge is stored with its time in a ring buffer, which evalKeys() replays sample by sample. So a
+// short press during a long loop() is not missed and the debouncing sees the edges at their time.
+// The ISR is the only writer of keyEventHead and evalKeys() the only writer of keyEventTail. Both
+// are single bytes, which are read and written atomically, so the ring buffer needs no lock.
+
+#define KEYEVENTS 16 // size of the ring buffer, must be a power of two
+
+// keys on port B as bits of keyBits_t
+constexpr keyBits_t keysOnPortB(int i = 0) {
+  return (i >= NUMDIRECTKEYS) ? 0
+                              : (((pinPort[keyList[i]] == KEYPORT_B) ? ((keyBits_t)1 << i) : 0) |
+                                 keysOnPortB(i + 1));
+}
+static_assert(keysOnPortB() != 0, "KEYS_ISR needs keys on port B: pins 8..11 or 14..17");
+
+struct KeyEvent {
+  uint16_t ms;  // lower 16 bits of millis()
+  uint8_t pins; // PINB after the edge
+};
+static volatile KeyEvent keyEvents[KEYEVENTS];
+static volatile uint8_t keyEventHead = 0;       // next event to be written by the ISR
+static volatile uint8_t keyEventTail = 0;       // next event to be replayed by evalKeys()
+static volatile uint16_t keyEventOverflows = 0; // edges lost, because the ring buffer was full
+static uint8_t keyEventPins;                    // PINB at the time of the last replayed sample
+
+// an edge on one of the keys on port B
+ISR(PCINT0_vect) {
+  uint8_t next = (keyEventHead + 1) & (KEYEVENTS - 1);
+  if (next == keyEventTail) {
+    // the ring buffer is full: the last stored edge takes the pins as they are now, so that at least
+    // the state after the lost edges is replayed
+    keyEvents[(keyEventHead - 1) & (KEYEVENTS - 1)].pins = PINB;
+    keyEventOverflows++;
+    return;
+  }
+  keyEvents[keyEventHead].ms = millis();
+  keyEvents[keyEventHead].pins = PINB;
+  keyEventHead = next;
+}
+
+// enable the pin change interrupt for the keys on port B
+static void keyEventsStart() {
+  keyEventPins = PINB;
+  PCMSK0 = keyPortMask(KEYPORT_B);
+  PCIFR = (1 << PCIF0);
+  PCICR |= (1 << PCIE0);
+}
+
+// Replay the edges until the time ms.
+// returns the pressed keys on port B at this time
+static keyBits_t replayKeyEvents(uint16_t ms) {
+  uint8_t tail = keyEventTail;
+  while (tail != keyEventHead && (int16_t)(keyEvents[tail].ms - ms) <= 0) {
+    keyEventPins = keyEvents[tail].pins;
+    tail = (tail + 1) & (KEYEVENTS - 1);
+  }
+  keyEventTail = tail;
+
+  keyBits_t keys = 0;
+  for (int i = 0; i < NUMDIRECTKEYS; i++) {
+    if (pinPort[keyList[i]] == KEYPORT_B && !(keyEventPins & (1 << pinBit[keyList[i]]))) {
+      keys |= (keyBits_t)1 << i; // pulled to ground: pressed
+    }
+  }
+  return keys;
+}
+
+// Drop all captured edges and take the keys on port B as they are now. The times of the edges are
+// only 16 bit, so they can't be replayed after a gap of more than 32 s.
+static void resyncKeyEvents() {
+  keyEventTail = keyEventHead;
+  keyEventPins = PINB;
 }
 
+// Get the number of edges, which were lost, because evalKeys() didn't replay them in time
+uint16_t getKeyEventOverflows() {
+  noInterrupts();
+  uint16_t overflows = keyEventOverflows;
+  interrupts();
+  return overflows;
+}
+#endif
+#else
 // Function to read and store the digital states for each of the keys
 void readAllFromKeys(int *keyVals) {
-  for (int i = 0; i < NUMKEYS; i++) {
+  for (int i = 0; i < NUMDIRECTKEYS; i++) {
     keyVals[i] = digitalRead(keyList[i]);
   }
+#if NUMMATRIXKEYS > 0
+  scanKeyMatrix(&keyVals[NUMDIRECTKEYS]);
+#endif
+}
+#endif
+
+// vertical counters: the two bits of the counter of key i are bit i of keyCount0 and keyCount1
+static keyBits_t keyCount0, keyCount1;
+static keyBits_t keysDebounced; // debounced state of all keys, 1 = pressed
+
+// Debounce all keys at once with the next sample of the raw keys (1 = pressed). The counter of a key
+// counts the samples in a row, which differ from its debounced state, and is reset by an equal
+// sample. After four differing samples, the debounced state changes. This debounces pressing and
+// releasing the same way. Only the keys in mask are sampled, the others keep their counters.
+// returns the keys, whose debounced state changed
+static keyBits_t debounceKeys(keyBits_t sample, keyBits_t mask) {
+  keyBits_t delta = (sample ^ keysDebounced) & mask;
+  keyCount1 = ((keyCount1 ^ keyCount0) & delta) | (keyCount1 & ~mask);
+  keyCount0 = (~keyCount0 & delta) | (keyCount0 & ~mask);
+  keyBits_t toggled = delta & ~(keyCount0 | keyCount1); // the counter wrapped around after 4 samples
+  keysDebounced ^= toggled;
+  return toggled;
 }
 
 // Evaluate and debounce all keys from the raw keyVals into the debounced keyOut event or the
 // debounced keyState. The keyOut is only 1 for one iteration of the loop.
+// The keys are sampled every DEBOUNCE_SAMPLE_MS, a change is taken after four equal samples.
+// With KEYS_ISR, the samples of the keys on port B, which were missed by a long loop(), are
+// replayed from the captured edges.
 void evalKeys(int *keyVals, uint8_t *keyOut, uint8_t *keyState) {
-  static unsigned long timestamp[NUMKEYS]; // needed for key evaluation
+  static unsigned long lastSample;
+  static keyBits_t lastPressed; // keys with a keyOut event in the last iteration
+
+  keyBits_t toggled = 0;
+#ifdef KEYS_ISR
+  // replay the captured edges of the keys on port B in the samples, which the loop() has missed,
+  // but stop at the first change, so that every change is seen by one iteration of the loop
+  if (millis() - lastSample > 50 * DEBOUNCE_SAMPLE_MS) {
+    if (millis() - lastSample > 30000) {
+      resyncKeyEvents(); // loop() was blocked for so long, that the times of the edges wrapped
+    }
+    lastSample = millis() - 50 * DEBOUNCE_SAMPLE_MS; // don't replay more than 50 samples
+  }
+  while (toggled == 0 && millis() - lastSample >= 2 * DEBOUNCE_SAMPLE_MS) {
+    lastSample += DEBOUNCE_SAMPLE_MS;
+    toggled = debounceKeys(replayKeyEvents(lastSample), keysOnPortB());
+  }
+#endif
+  if (toggled == 0 && millis() - lastSample >= DEBOUNCE_SAMPLE_MS) {
+    lastSample = millis();
+#ifdef KEYS_ISR
+    replayKeyEvents(lastSample); // these edges are already in keyVals
+    if (keyEventTail == keyEventHead) {
+      keyEventPins = PINB; // all edges are replayed: take the pins, in case an edge was lost
+    }
+#endif
+    keyBits_t sample = 0;
+    for (int i = 0; i < NUMKEYS; i++) {
+      // The keys are configured with pull_up, see setupKeys() and are pulled to ground, when
+      // pressed. Therefore, the pressed key is false, which is an inverted logic
+      if (!keyVals[i]) {
+        sample |= (keyBits_t)1 << i;
+      }
+    }
+    toggled = debounceKeys(sample, (keyBits_t)~0);
+  }
+  keyBits_t pressed = toggled & keysDebounced;
+  if (toggled == 0 && lastPressed == 0) {
+    return; // nothing changed and no keyOut event to clear
+  }
+  lastPressed = pressed;
 
-  // Button Evaluation
   for (int i = 0; i < NUMKEYS; i++) {
-    // The keys are configured with pull_up, see setupKeys() and are pulled to ground, when pressed.
-    // Therefore, the pressed key is false, which is an inverted logic
-    if (!keyVals[i]) { // the key is pressed
-      // Making sure button cannot trigger multiple times which would result in overloading HID.
-      if (keyState[i] == 0) { // if the button has not been pressed lately:
-        keyOut[i] = 1;   // this is the variable telling the outside world only one iteration, that
-                         // the key was pressed
-        keyState[i] = 1; // remember, that we already told the outside world about this key
-        timestamp[i] = millis(); // remember the time, the button was pressed
+    keyBits_t bit = (keyBits_t)1 << i;
+    // this is the variable telling the outside world only one iteration, that the key was pressed
+    keyOut[i] = (pressed & bit) ? 1 : 0;
+    if (toggled & bit) {
+      // the keyState is only written on changes, the encoder may use some keys, see calcEncoderAsKey()
+      keyState[i] = (keysDebounced & bit) ? 1 : 0;
 #ifdef DEBUG_KEYS
+      if (keyState[i]) {
         Serial.println("");
         Serial.print("Key: "); // this is always sent over the serial console, and not only in debug
         Serial.println(i);
-#endif
-      } else { // the button was already pressed and is still pressed (and the event sent in the
-               // last loop), don't send the keyOut event again.
-        keyOut[i] = 0;
-      }
-    } else {                  // the button is not pressed
-      if (keyState[i] == 1) { // has it been pressed lately?
-        // debouncing:
-        if (millis() - timestamp[i] >
-            DEBOUNCE_KEYS_MS) { // check if the last button press is long enough in the past
-          keyState[i] = 0;      // reset this marker and allow a new button press
-        }
       }
+#endif
     }
   }
 }
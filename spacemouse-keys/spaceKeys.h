@@ -1,6 +1,19 @@
 // header for spaceKeys.cpp
 // Handle all the keys for the spacemouse
+#ifndef SPACEKEYS_h
+#define SPACEKEYS_h
+
+// The keys of the key matrix (KEYMATRIX_NUMROWS x KEYMATRIX_NUMCOLS) follow the keys in KEYLIST
+#ifdef KEYMATRIX_ROWS
+#define NUMMATRIXKEYS (KEYMATRIX_NUMROWS * KEYMATRIX_NUMCOLS)
+#else
+#define NUMMATRIXKEYS 0
+#endif
+#define NUMDIRECTKEYS (NUMKEYS - NUMMATRIXKEYS)
 
 void readAllFromKeys(int* keyVals);
 void setupKeys();
 void evalKeys(int* keyVals, uint8_t* keyOut, uint8_t* keyState);
+uint16_t getKeyEventOverflows();
+
+#endif // SPACEKEYS_h
@@ -24,6 +24,11 @@
 // header to calculate the kinematics of the mouse
 #include "kinematics.h"
 
+#ifdef ADC_ISR
+// if the analog channels are read in the background
+#include "adcSampler.h"
+#endif
+
 // header file for reading the keys
 #include "spaceKeys.h"
 
@@ -39,6 +44,11 @@
 #include "ledring.h"
 #endif
 
+#ifdef KEYMAP
+// if the buttons are assigned by the key map instead of BUTTONLIST
+#include "keyMap.h"
+#endif
+
 void setup();
 void loop();
 #ifdef LEDpin
@@ -102,7 +112,22 @@ ParamData par = {.values = &parStorage,
                      {PARAM_TYPE_INT, "COMP_MDIFF", &parStorage.compMinMaxDiff},         //      30
                      {PARAM_TYPE_INT, "COMP_CDIFF", &parStorage.compCenterDiff},         //      31
                      {PARAM_TYPE_INT, "RAXIS_ECH", &parStorage.rotAxisEchos},            //      32
-                     {PARAM_TYPE_INT, "RAXIS_STR", &parStorage.rotAxisSimStrength}       //      33
+                     {PARAM_TYPE_INT, "RAXIS_STR", &parStorage.rotAxisSimStrength},      //      33
+                     {PARAM_TYPE_INT, "HID_RATE", &parStorage.hidRate},                  //      34
+                     {PARAM_TYPE_INT, "HID_EPINT", &parStorage.hidEpInterval}            //      35
+                 },
+                 .arrays = {
+                     {PARAM_TYPE_BYTE, "MIX", parStorage.mixMatrix, 6 * 8}, // 100 ... 147
+                     {PARAM_TYPE_BYTE, "MIX_SHIFT", parStorage.mixShift, 6}, // 200 ... 205
+                     {PARAM_TYPE_INT, "MINVALS", parStorage.minVals, 8},    // 300 ... 307
+                     {PARAM_TYPE_INT, "MAXVALS", parStorage.maxVals, 8},    // 400 ... 407
+#ifdef KEYMAP
+                     {PARAM_TYPE_BYTE, "KM_TAP", parStorage.kmTap, 2 * NUMKEYS},       // 500 ...
+                     {PARAM_TYPE_BYTE, "KM_HOLD", parStorage.kmHold, 2 * NUMKEYS},     // 600 ...
+                     {PARAM_TYPE_BYTE, "KM_DOUBLE", parStorage.kmDouble, NUMKEYS},     // 700 ...
+                     {PARAM_TYPE_BYTE, "KM_CHORD", parStorage.kmChord, 3 * KEYMAP_CHORDS}, // 800 ...
+                     {PARAM_TYPE_INT, "KM_TIMES", parStorage.kmTimes, 3},              // 900 ... 902
+#endif
                  }};
 
 // store raw value of the keys, without debouncing
@@ -122,12 +147,22 @@ void setup() {
 #if PARAM_IN_EEPROM > 0
   getParametersFromEEPROM(par);
 #endif
+  // build the tables of the kinematics (only if they haven't been built for the parameters from the EEPROM)
+  updateKinematicTables(par);
+
+  // the HID timing is taken from the parameters
+  SpaceMouseHID.begin(par);
 
 // setup the keys e.g. to internal pull-ups
 #if NUMKEYS > 0
   setupKeys();
 #endif
 
+#ifdef ADC_ISR
+  // start reading the analog channels in the background
+  adcStart(DEFAULT);
+#endif
+
 #ifdef HALLEFFECT
   // Set the ADC reference voltage to 2,56V if HALLEFFECT is defined, 5V otherwise.
   // It is important the reference Voltage is set before the Zeroing of the sensors is executed.
@@ -140,9 +175,14 @@ void setup() {
   Serial.setTimeout(30000); // the serial interface will wait for new menu number for max.30s
 
   // Read idle/centre positions for joysticks.
-  // zero the joystick position 500 times (takes approx. 480 ms)
-  // during setup() we are not interested in the debug output: debugFlag = false
-  busyZeroing(centerPoints, 750, false);
+  // The zeroing runs in the background of loop(), the velocity is zero until it is done.
+#ifdef FAST_START
+  // restore the stored center points, if they are confirmed by a short burst of readings
+  fastZeroing(centerPoints, par);
+#else
+  // zero the joystick position 750 times (takes approx. 0.7 s)
+  startZeroing(750, 0);
+#endif
   for (int i = 0; i < 8; i++) {
     offsets[i] = 0;
   }
@@ -210,6 +250,7 @@ void loop() {
       Serial.println(F("  2 centered values -500..+500"));
       Serial.println(F(" 11 auto calibrate centers, show deadzones"));
       Serial.println(F(" 20 find min/max-values over 20s (move stick)"));
+      Serial.println(F(" 21 stream values (3) for calibration tool"));
       Serial.println(F("  3 centered values w.deadzones -350..+350"));
       Serial.println(F(" 31 drift compensation offsets"));
       Serial.println(F("  4 velocity- (trans-/rot-)values -350..+350"));
@@ -217,6 +258,8 @@ void loop() {
       Serial.println(F("  6 velocity after kill-keys and keys"));
       Serial.println(F(" 61 velocity after axis-switch, exclusive"));
       Serial.println(F("  7 loop-frequency-test"));
+      Serial.println(F(" 71 HID report age (sample to send)"));
+      Serial.println(F(" 72 sent HID reports (hex)"));
       Serial.println(F("  8 key-test, button-codes to send"));
       Serial.println(F("  9 encoder wheel-test"));
 #if PARAM_IN_EEPROM > 0
@@ -240,8 +283,18 @@ void loop() {
 #endif
   }
 
+  // take the parameters written via the HID parameter report (ADV_HID_PARAMS) and save them, outside
+  // of the USB interrupt
+  SpaceMouseHID.takeParamReport();
+#if (PARAM_IN_EEPROM > 0)
+  if (SpaceMouseHID.takeSaveRequest()) {
+    putParametersToEEPROM(par);
+  }
+#endif
+
   //--- Read joystick values. 0-1023
-  readAllFromJoystick(rawReads);
+  SpaceMouseHID.startSample(); // timing of the HID reports, see ADV_HID_SOF
+  bool newFrame = readAllFromJoystick(rawReads, false);
 
 //--- Reading of key presses
 #if NUMKEYS > 0
@@ -261,14 +314,44 @@ void loop() {
 
   //--- calibrate the joystick
   if (debug == 11) {
-    // As this is called in the debug=11, we do more iterations.
-    busyZeroing(centerPoints, 2000, true);
-    debug = -1; // after function is done, leave this debug mode to "off" (-1)
+    // As this is called in the debug=11, we do more iterations. The result is reported when the
+    // zeroing in the background is done.
+#ifdef FAST_START
+    startZeroing(2000, ZEROING_REPORT | ZEROING_STORE);
+#else
+    startZeroing(2000, ZEROING_REPORT);
+#endif
+    debug = -1; // leave this debug mode to "off" (-1)
+  }
+
+  //--- calibrate the joystick on request of the host, e.g. "Calibrate" in the SpaceNavigator driver
+  if (SpaceMouseHID.takeCalibrateRequest()) {
+    startZeroing(750, ZEROING_KEEP | ZEROING_STORE);
+  }
+
+#ifdef RECENTER_INTERVAL
+  //--- re-center the joysticks periodically, while they are not touched
+  static unsigned long lastRecentering = 0;
+  if (!isZeroing() && (millis() - lastRecentering > RECENTER_INTERVAL * 1000UL)) {
+    startZeroing(750, ZEROING_BACKGROUND);
+    lastRecentering = millis();
+  }
+#endif
+
+  //--- zero the joysticks in the background, one reading per new frame
+  if (newFrame) {
+    uint8_t zeroing = zeroingStep(rawReads, centerPoints, par);
+    if (zeroing == ZEROING_DONE || zeroing == ZEROING_WARNED) {
+      // the new center points already contain the drift
+      for (int i = 0; i < 8; i++) {
+        offsets[i] = 0;
+      }
+    }
   }
 
   //--- Calculate drift compensation offsets
-  if ((par.values->compEnabled == 1) &&
-      (debug != 20)) { // only when not in debug 20 = find min/max values
+  if ((par.values->compEnabled == 1) && (debug != 20) && // only when not in debug 20 = find min/max values
+      !zeroingHoldsVelocity()) { // and not while the center points are unknown
     compensateDrifts(rawReads, centerPoints, offsets, par);
   } else {
     for (int i = 0; i < 8; i++) {
@@ -289,7 +372,7 @@ void loop() {
   //--- calibrate MinMax values
   if (debug == 20) {
     // has to be (re-)called, as long as it doesn't signal "done"
-    if (calcMinMax(centered) == 0) { // when calcMinMax() signals 0="done/idle":
+    if (calcMinMax(centered, par) == 0) { // when calcMinMax() signals 0="done/idle":
       debug = -1;                    // leave this debug-mode 20 to "off" (-1)
     }
   }
@@ -309,9 +392,22 @@ void loop() {
     debugOutput2(centered);
   }
 
+  // Stream the same values as lines of numbers for the calibration of the mixing matrix with
+  // progModePy/calibrateMixing.py
+  if (debug == 21) {
+    debugOutput21(centered);
+  }
+
   //--- Calculate the kinematic (centered->velocity)
   calculateKinematic(centered, velocity, par);
 
+  // the velocity is zero, until the zeroing has committed the new center points
+  if (zeroingHoldsVelocity()) {
+    for (int i = 0; i < 6; i++) {
+      velocity[i] = 0;
+    }
+  }
+
 //--- if an encoder wheel is used, calculate the velocity of the wheel
 //    and replace one of the former calculated velocities
 #if (ROTARY_AXIS > 0) && (ROTARY_AXIS < 7)
@@ -321,6 +417,15 @@ void loop() {
 //--- if defined, evaluate keys
 #if NUMKEYS > 0
   evalKeys(keyVals, keyOut, keyState);
+#ifdef KEYS_ISR
+  // report, if edges of the keys were lost, because the ring buffer of the pin change interrupt was full
+  static uint16_t keyEventOverflows = 0;
+  if (debug == 8 && getKeyEventOverflows() != keyEventOverflows) {
+    keyEventOverflows = getKeyEventOverflows();
+    Serial.print(F("Key edges lost: "));
+    Serial.println(keyEventOverflows);
+  }
+#endif
 #endif
 
 // The encoder wheel shall be treated as a key
@@ -379,16 +484,29 @@ void loop() {
     debugOutput4(velocity, keyOut);
   }
 
+#ifdef KEYMAP
+  // the key map sorts the keys into the bits of the buttons instead of BUTTONLIST
+  static uint8_t keyMapData[4];
+  evalKeyMap(keyState, keyMapData, par, (debug == 8));
+  SpaceMouseHID.send_command(velocity[ROTX], velocity[ROTY], velocity[ROTZ], velocity[TRANSX],
+                             velocity[TRANSY], velocity[TRANSZ], keyMapData, debug);
+#else
   SpaceMouseHID.send_command(velocity[ROTX], velocity[ROTY], velocity[ROTZ], velocity[TRANSX],
                              velocity[TRANSY], velocity[TRANSZ], keyState, debug);
+#endif
 
   // update and report at what frequency the loop is running
   if (debug == 7) {
     updateFrequencyReport();
   }
 
+  // report the histogram of the age of the samples in the HID reports
+  if (debug == 71) {
+    SpaceMouseHID.printReportAge();
+  }
+
   // Check for the LED state by calling updateLEDState.
-  // This empties the USB input buffer and checks for the corresponding report.
+  // This drains the USB input buffer and dispatches all output reports, e.g. LED and calibrate.
   SpaceMouseHID.updateLEDState();
 
 #ifdef LEDpin
@@ -428,13 +546,21 @@ void lightSimpleLED(boolean light) {
 void setAnalogReferenceVoltage(int dbg) {
   if (dbg == 1) { // Set the reference voltage for the AD Convertor to 5V only for the first
                   // calibration step (pinout/inversion calibration).
+#ifdef ADC_ISR
+    adcStart(DEFAULT);
+#else
     analogReference(DEFAULT);
+#endif
 #ifdef DEBUG_ADC
     Serial.println(F("Setting analog reference to 5V."));
 #endif
   } else { // Set the reference voltage for the AD Convertor to 2.56V in order to get larger
            // sensitivity.
+#ifdef ADC_ISR
+    adcStart(INTERNAL);
+#else
     analogReference(INTERNAL);
+#endif
 #ifdef DEBUG_ADC
     Serial.println(F("Setting analog reference to 2.56V."));
 #endif
@@ -446,7 +572,7 @@ void setAnalogReferenceVoltage(int dbg) {
   delay(100);
   int tempReads[8];
   for (int i = 0; i <= 8; i++) {
-    readAllFromJoystick(tempReads);
+    readAllFromJoystick(tempReads, true);
   }
 }
 #endif
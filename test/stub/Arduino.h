@@ -0,0 +1,100 @@
+// Minimal Arduino API for the tests on the PC, see test/Makefile
+// The time, the analog and the digital pins are simulated by the tests.
+#pragma once
+#include <stdint.h>
+#include <stddef.h>
+#include <string.h>
+#include <stdlib.h>
+#include <stdio.h>
+#include <math.h>
+#include <avr/io.h>
+#include <avr/interrupt.h>
+#include <avr/pgmspace.h>
+
+typedef bool boolean;
+typedef uint8_t byte;
+#define ARDUINO_ARCH_AVR 1
+
+#define A0 18
+#define A1 19
+#define A2 20
+#define A3 21
+#define A4 22
+#define A5 23
+#define A6 24
+#define A7 25
+#define A8 26
+#define A9 27
+#define A10 28
+#define A11 29
+#define HIGH 1
+#define LOW 0
+#define INPUT 0
+#define OUTPUT 1
+#define INPUT_PULLUP 2
+#define DEFAULT 1
+#define INTERNAL 3
+#define CHANGE 1
+#define HEX 16
+#define F(x) x
+#define lowByte(w) ((uint8_t)((w) & 0xff))
+#define highByte(w) ((uint8_t)((w) >> 8))
+#define constrain(amt, low, high) ((amt) < (low) ? (low) : ((amt) > (high) ? (high) : (amt)))
+#define min(a, b) ((a) < (b) ? (a) : (b))
+#define max(a, b) ((a) > (b) ? (a) : (b))
+#define noInterrupts() cli()
+#define interrupts() sei()
+
+// analog pin -> ADC channel of the ATmega32U4, see pins_arduino.h of the leonardo variant
+inline const uint8_t analog_pin_to_channel_PGM[] = {7, 6, 5, 4, 1, 0, 8, 10, 11, 12, 13, 9};
+#define analogPinToChannel(P) (pgm_read_byte(analog_pin_to_channel_PGM + (P)))
+#define NOT_AN_INTERRUPT -1
+#define digitalPinToInterrupt(p) \
+  ((p) == 3 ? 0 : ((p) == 2 ? 1 : ((p) == 0 ? 2 : ((p) == 1 ? 3 : ((p) == 7 ? 4 : NOT_AN_INTERRUPT)))))
+
+// simulated time in us, advanced by the tests
+inline unsigned long hostMicros = 0;
+inline unsigned long micros() { return hostMicros; }
+inline unsigned long millis() { return hostMicros / 1000; }
+inline void delay(unsigned long ms) { hostMicros += ms * 1000; }
+inline void delayMicroseconds(unsigned int us) { hostMicros += us; }
+
+// simulated pins, set by the tests
+inline int hostPinLevel[32];
+inline int hostPinMode[32];
+inline int (*hostAnalogRead)(uint8_t pin) = nullptr;
+inline int analogRead(uint8_t pin) { return hostAnalogRead ? hostAnalogRead(pin) : 0; }
+inline void analogReference(uint8_t) {}
+inline int (*hostDigitalRead)(uint8_t pin) = nullptr;
+inline int digitalRead(uint8_t pin) { return hostDigitalRead ? hostDigitalRead(pin) : hostPinLevel[pin]; }
+inline void digitalWrite(uint8_t pin, uint8_t val) { hostPinLevel[pin] = val; }
+inline void pinMode(uint8_t pin, uint8_t mode) { hostPinMode[pin] = mode; }
+inline void (*hostInterrupts[5])() = {nullptr};
+inline void attachInterrupt(uint8_t irq, void (*isr)(), int) { hostInterrupts[irq] = isr; }
+
+// number of calls of map(), every one is a 32 bit division on the AVR (several hundred cycles)
+inline long hostMapCalls = 0;
+inline long map(long x, long in_min, long in_max, long out_min, long out_max) {
+  hostMapCalls++;
+  return (x - in_min) * (out_max - out_min) / (in_max - in_min) + out_min;
+}
+inline bool isDigit(char c) { return c >= '0' && c <= '9'; }
+inline char toLowerCase(char c) { return (c >= 'A' && c <= 'Z') ? c + 'a' - 'A' : c; }
+
+// the serial output is discarded
+struct HostSerial {
+  template <class T> size_t print(T) { return 0; }
+  template <class T> size_t print(T, int) { return 0; }
+  template <class T> size_t println(T) { return 0; }
+  template <class T> size_t println(T, int) { return 0; }
+  size_t println() { return 0; }
+  int available() { return 0; }
+  int peek() { return -1; }
+  int read() { return -1; }
+  float parseFloat() { return 0; }
+  void setTimeout(long) {}
+  size_t write(uint8_t) { return 1; }
+  size_t write(const uint8_t *, size_t n) { return n; }
+  int availableForWrite() { return 64; }
+};
+inline HostSerial Serial;
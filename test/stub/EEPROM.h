@@ -0,0 +1,20 @@
+// EEPROM of the ATmega32U4 as array for the tests on the PC
+#pragma once
+#include <stdint.h>
+#include <string.h>
+struct HostEEPROM {
+  uint8_t data[1024];
+  template <class T> T &get(int address, T &t) {
+    memcpy((void *)&t, &data[address], sizeof(T));
+    return t;
+  }
+  template <class T> const T &put(int address, const T &t) {
+    memcpy(&data[address], (const void *)&t, sizeof(T));
+    return t;
+  }
+  uint8_t read(int address) { return data[address]; }
+  void write(int address, uint8_t value) { data[address] = value; }
+  void update(int address, uint8_t value) { data[address] = value; }
+  unsigned length() { return sizeof(data); }
+};
+inline HostEEPROM EEPROM;
@@ -0,0 +1,17 @@
+// Definitions of the HID library of the Arduino AVR boards for the tests on the PC, see test/Makefile
+#pragma once
+#include "PluggableUSB.h"
+
+#define HID_GET_REPORT 0x01
+#define HID_GET_IDLE 0x02
+#define HID_GET_PROTOCOL 0x03
+#define HID_SET_REPORT 0x09
+#define HID_SET_IDLE 0x0A
+#define HID_SET_PROTOCOL 0x0B
+#define HID_REPORT_DESCRIPTOR_TYPE 0x22
+#define HID_REPORT_PROTOCOL 1
+#define HID_REPORT_TYPE_FEATURE 3
+
+typedef struct {
+  uint8_t len, dtype, addr, versionL, versionH, country, desctype, descLenL, descLenH;
+} HIDDescDescriptor;
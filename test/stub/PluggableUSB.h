@@ -0,0 +1,110 @@
+// Minimal USB core of the Arduino AVR boards for the tests on the PC, see test/Makefile
+// The endpoints are simulated: the tests decide, whether the IN endpoint has space for the next
+// report, and get every sent report and every sent descriptor. They put the reports of the host into
+// the OUT endpoint and the data stage of the control requests.
+#pragma once
+#include <Arduino.h>
+
+typedef struct {
+  uint8_t bmRequestType;
+  uint8_t bRequest;
+  uint8_t wValueL;
+  uint8_t wValueH;
+  uint16_t wIndex;
+  uint16_t wLength;
+} USBSetup;
+
+typedef struct {
+  uint8_t len, dtype, number, alternate, numEndpoints, interfaceClass, interfaceSubClass, protocol,
+      iInterface;
+} InterfaceDescriptor;
+
+// packed like on the AVR, so the descriptors have the bytes, which are sent to the host
+typedef struct __attribute__((packed)) {
+  uint8_t len, dtype, addr, attr;
+  uint16_t packetSize;
+  uint8_t interval;
+} EndpointDescriptor;
+
+#define D_INTERFACE(_n, _numEndpoints, _class, _subClass, _protocol) \
+  {9, 4, _n, 0, _numEndpoints, _class, _subClass, _protocol, 0}
+#define D_ENDPOINT(_addr, _attr, _packetSize, _interval) {7, 5, _addr, _attr, _packetSize, _interval}
+
+#define USB_DEVICE_CLASS_HUMAN_INTERFACE 0x03
+#define USB_ENDPOINT_IN(addr) (lowByte((addr) | 0x80))
+#define USB_ENDPOINT_OUT(addr) (lowByte((addr) | 0x00))
+#define USB_ENDPOINT_TYPE_INTERRUPT 0x03
+#define USB_EP_SIZE 64
+#define REQUEST_DEVICETOHOST_STANDARD_INTERFACE 0x81
+#define REQUEST_DEVICETOHOST_CLASS_INTERFACE 0xA1
+#define REQUEST_HOSTTODEVICE_CLASS_INTERFACE 0x21
+#define TRANSFER_PGM 0x80
+#define TRANSFER_RELEASE 0x40
+#define EP_TYPE_INTERRUPT_IN 0xC1
+#define EP_TYPE_INTERRUPT_OUT 0xC0
+
+class PluggableUSBModule {
+public:
+  PluggableUSBModule(uint8_t numEps, uint8_t numIfs, uint8_t *epType) {}
+
+protected:
+  virtual bool setup(USBSetup &setup) = 0;
+  virtual int getInterface(uint8_t *interfaceCount) = 0;
+  virtual int getDescriptor(USBSetup &setup) = 0;
+  uint8_t pluggedInterface = 0;
+  uint8_t pluggedEndpoint = 1;
+};
+
+struct PluggableUSB_ {
+  bool plug(PluggableUSBModule *) { return true; }
+};
+inline PluggableUSB_ &PluggableUSB() {
+  static PluggableUSB_ obj;
+  return obj;
+}
+
+// simulated IN endpoint: free bytes in the bank and the sent reports, set and read by the tests
+inline int hostUsbSendSpace = USB_EP_SIZE;
+inline void (*hostUsbSent)(const uint8_t *report, int len) = nullptr;
+
+inline uint8_t USB_SendSpace(uint8_t ep) { return hostUsbSendSpace; }
+inline int USB_Send(uint8_t ep, const void *data, int len) {
+  if (hostUsbSent) {
+    hostUsbSent((const uint8_t *)data, len);
+  }
+  return len;
+}
+
+// simulated control endpoint: the sent descriptors and the data stage of a request of the host
+inline void (*hostUsbControlSent)(const uint8_t *data, int len) = nullptr;
+inline const uint8_t *hostUsbControlData = nullptr;
+inline int hostUsbControlLen = 0;
+
+inline int USB_SendControl(uint8_t flags, const void *d, int len) {
+  if (hostUsbControlSent) {
+    hostUsbControlSent((const uint8_t *)d, len);
+  }
+  return len;
+}
+inline int USB_RecvControl(void *d, int len) {
+  memset(d, 0, len);
+  if (hostUsbControlData) {
+    memcpy(d, hostUsbControlData, min(len, hostUsbControlLen));
+  }
+  return len;
+}
+
+// simulated OUT endpoint: one report of the host, which is read by USB_Recv()
+inline uint8_t hostUsbOut[USB_EP_SIZE];
+inline int hostUsbOutLen = 0, hostUsbOutRead = 0;
+
+inline uint8_t USB_Available(uint8_t ep) { return hostUsbOutLen - hostUsbOutRead; }
+inline int USB_Recv(uint8_t ep, void *data, int len) {
+  len = min(len, hostUsbOutLen - hostUsbOutRead);
+  memcpy(data, &hostUsbOut[hostUsbOutRead], len);
+  hostUsbOutRead += len;
+  return len;
+}
+inline int USB_Recv(uint8_t ep) {
+  return (hostUsbOutRead < hostUsbOutLen) ? hostUsbOut[hostUsbOutRead++] : -1;
+}
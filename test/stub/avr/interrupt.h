@@ -0,0 +1,5 @@
+#pragma once
+// an ISR is a plain function, which the tests call to simulate the interrupt
+#define ISR(v) void v(void)
+#define cli()
+#define sei()
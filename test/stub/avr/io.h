@@ -0,0 +1,29 @@
+// Registers of the ATmega32U4 as plain variables for the tests on the PC
+#pragma once
+#include <stdint.h>
+
+#define HOST_REGISTER(n) inline volatile uint8_t n;
+HOST_REGISTER(ADCSRA) HOST_REGISTER(ADCSRB) HOST_REGISTER(ADMUX) HOST_REGISTER(DIDR0)
+HOST_REGISTER(DIDR2) HOST_REGISTER(PINB) HOST_REGISTER(PINC) HOST_REGISTER(PIND)
+HOST_REGISTER(PINE) HOST_REGISTER(PINF) HOST_REGISTER(PCICR) HOST_REGISTER(PCMSK0)
+HOST_REGISTER(PCIFR) HOST_REGISTER(UDFNUML) HOST_REGISTER(UDFNUMH) HOST_REGISTER(UDINT)
+HOST_REGISTER(UDIEN) HOST_REGISTER(EIMSK) HOST_REGISTER(EICRA) HOST_REGISTER(EICRB)
+HOST_REGISTER(DDRB) HOST_REGISTER(PORTB) HOST_REGISTER(PORTD) HOST_REGISTER(SREG)
+inline volatile uint16_t ADC;
+
+#define ADEN 7
+#define ADSC 6
+#define ADATE 5
+#define ADIF 4
+#define ADIE 3
+#define ADPS2 2
+#define ADPS1 1
+#define ADPS0 0
+#define MUX5 5
+#define REFS1 7
+#define REFS0 6
+#define PCIE0 0
+#define PCIF0 0
+#define SOFI 2
+#define SOFE 2
+#define __AVR_ATmega32U4__ 1
@@ -0,0 +1,7 @@
+#pragma once
+#define PROGMEM
+#define pgm_read_byte(a) (*(const uint8_t *)(a))
+#define pgm_read_word(a) (*(const uint16_t *)(a))
+#define pgm_read_dword(a) (*(const uint32_t *)(a))
+#define PGM_P const char *
+#define memcpy_P memcpy
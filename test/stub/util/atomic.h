@@ -0,0 +1,3 @@
+#pragma once
+#define ATOMIC_BLOCK(x) for (int _atomic = 1; _atomic; _atomic = 0)
+#define ATOMIC_RESTORESTATE 0
@@ -0,0 +1,30 @@
+// Helpers for the tests on the PC, see test/Makefile
+#pragma once
+#include <stdio.h>
+#include <time.h>
+
+static int testFailures = 0;
+
+// check a condition, print the failure and continue with the test
+#define CHECK(cond, ...)                                                                           \
+  do {                                                                                             \
+    if (!(cond)) {                                                                                 \
+      testFailures++;                                                                              \
+      printf("%s:%d: CHECK(%s) failed: ", __FILE__, __LINE__, #cond);                             \
+      printf(__VA_ARGS__);                                                                         \
+      printf("\n");                                                                                \
+    }                                                                                              \
+  } while (0)
+
+// print the result, the return value of main()
+static int testResult(const char *name) {
+  printf("%s: %s\n", name, testFailures ? "FAILED" : "passed");
+  return testFailures ? 1 : 0;
+}
+
+// time of the PC in ns, for the benchmarks
+static double hostNanoseconds() {
+  struct timespec now;
+  clock_gettime(CLOCK_MONOTONIC, &now);
+  return now.tv_sec * 1e9 + now.tv_nsec;
+}
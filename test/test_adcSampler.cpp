@@ -0,0 +1,96 @@
+// Test of the background acquisition in adcSampler.cpp (ADC_ISR) with a simulated ADC:
+// the test plays the ADC hardware and calls the ADC-complete-interrupt for every conversion.
+
+#define ADC_ISR
+#define PINLIST {A0, A1, A2, A3, A6, A7, A8, A9}
+#define INVERTLIST {0, 0, 1, 0, 0, 0, 0, 1}
+#include "config.h"
+#include "test.h"
+
+#include "adcSampler.cpp"
+
+static const uint8_t pins[8] = PINLIST;
+static int analogValue[32]; // value of the simulated analog input of every pin
+
+// the pin, which is selected by the multiplexer of the ADC
+static int selectedPin() {
+  uint8_t mux = (ADMUX & 0x07) | (((ADCSRB >> MUX5) & 0x01) << 3);
+  for (int pin = 0; pin < 12; pin++) {
+    if (analog_pin_to_channel_PGM[pin] == mux) {
+      return A0 + pin;
+    }
+  }
+  return -1;
+}
+
+// finish the running conversion and call the interrupt
+static void convert(int n = 1) {
+  for (int i = 0; i < n; i++) {
+    CHECK(ADCSRA & (1 << ADSC), "no conversion started");
+    ADCSRA &= ~(1 << ADSC);
+    int pin = selectedPin();
+    CHECK(pin >= 0, "mux %d selects no analog pin", ADMUX & 0x07);
+    ADC = (pin >= 0) ? analogValue[pin] : 0;
+    ADC_vect();
+  }
+}
+
+static void setValues(int offset) {
+  for (int i = 0; i < 8; i++) {
+    analogValue[pins[i]] = offset + 100 * i;
+  }
+}
+
+static void checkFrame(const int *frame, int offset, const char *what) {
+  static const int invert[8] = INVERTLIST;
+  for (int i = 0; i < 8; i++) {
+    int expected = invert[i] ? ADC_MAXVAL - (offset + 100 * i) : offset + 100 * i;
+    CHECK(frame[i] == expected, "%s: channel %d is %d instead of %d", what, i, frame[i], expected);
+  }
+}
+
+int main() {
+  int frame[8];
+
+  adcStart(DEFAULT);
+  CHECK(ADMUX >> 6 == DEFAULT, "reference bits %d", ADMUX >> 6);
+  CHECK(ADCSRA & (1 << ADIE), "interrupt not enabled");
+  CHECK(!adcReadFrame(frame, false), "new frame before any conversion");
+
+  // one complete frame with all channels, A6 ... A9 need the MUX5 bit
+  setValues(10);
+  convert(8);
+  CHECK(adcReadFrame(frame, false), "no new frame after eight conversions");
+  checkFrame(frame, 10, "first frame");
+  CHECK(!adcReadFrame(frame, false), "the same frame is reported as new twice");
+
+  // double buffer: a half converted frame is not visible, the last complete frame is returned
+  setValues(20);
+  convert(5);
+  CHECK(!adcReadFrame(frame, false), "new frame after five conversions");
+  checkFrame(frame, 10, "while the next frame is converted");
+  convert(3);
+  CHECK(adcReadFrame(frame, false), "no new frame after the second frame");
+  checkFrame(frame, 20, "second frame");
+
+  // the loop missed some frames: the latest one is returned
+  for (int f = 3; f < 10; f++) {
+    setValues(10 * f);
+    convert(8);
+  }
+  CHECK(adcReadFrame(frame, false), "no new frame after several frames");
+  checkFrame(frame, 90, "latest of several frames");
+
+  // restart with the internal reference: the round robin starts again at the first channel
+  convert(3);
+  ADCSRA &= ~(1 << ADSC); // the running conversion completes without interrupt, adcStart() waits for it
+  adcStart(INTERNAL);
+  CHECK(ADMUX >> 6 == INTERNAL, "reference bits %d after the restart", ADMUX >> 6);
+  CHECK(selectedPin() == pins[0], "the restart doesn't select the first channel");
+  setValues(5);
+  convert(8);
+  CHECK(adcReadFrame(frame, false), "no new frame after the restart");
+  checkFrame(frame, 5, "frame after the restart");
+
+  return testResult("adcSampler");
+}
@@ -0,0 +1,132 @@
+// Test and benchmark of the scaling of the centered values in FilterAnalogReadOuts() (kinematics.cpp):
+// the precalculated factors must give exactly the results of map() for every input. Compiled with
+// ADC_OVERSAMPLING 16, so the inputs cover +/-4092 and the fallback to map() for large inputs.
+
+#include <random> // before Arduino.h with its min() and max() macros
+
+#define ADC_OVERSAMPLING 16
+#include "config.h"
+#include "test.h"
+
+#include "kinematics.cpp"
+#include "parameterMenu.cpp"
+
+static ParamStorage values;
+static ParamData par = {.values = &values};
+
+// FilterAnalogReadOuts() with map(), as before the precalculated factors
+static void filterWithMap(int *centered, ParamData &par) {
+  int16_t *minVals = par.values->minVals;
+  int16_t *maxVals = par.values->maxVals;
+  int deadzone = par.values->deadzone * ADC_SCALE;
+  for (int i = 0; i < 8; i++) {
+    if (centered[i] < deadzone && centered[i] > -deadzone) {
+      centered[i] = 0;
+    } else if (centered[i] < 0) {
+      centered[i] = map(centered[i], (long)minVals[i] * ADC_SCALE, -deadzone, -TOTALSENSITIVITY, 0);
+    } else {
+      centered[i] = map(centered[i], deadzone, (long)maxVals[i] * ADC_SCALE, 0, TOTALSENSITIVITY);
+    }
+  }
+}
+
+// compare all inputs for the actual parameters, return the number of differences
+static long compareAllInputs() {
+  long differences = 0;
+  for (int x = -ADC_MAXVAL; x <= ADC_MAXVAL; x++) {
+    int centered[8], expected[8];
+    for (int i = 0; i < 8; i++) {
+      centered[i] = expected[i] = x;
+    }
+    FilterAnalogReadOuts(centered, par);
+    filterWithMap(expected, par);
+    for (int i = 0; i < 8; i++) {
+      if (centered[i] != expected[i]) {
+        if (differences == 0) {
+          CHECK(centered[i] == expected[i], "min %d, max %d, deadzone %d, input %d: %d instead of %d",
+                values.minVals[i], values.maxVals[i], values.deadzone, x, centered[i], expected[i]);
+        }
+        differences++;
+      }
+    }
+  }
+  return differences;
+}
+
+// time per call in ns on the PC. The PC divides in hardware, so the number of map() calls is returned, too:
+// every one is a 32 bit division, which takes several hundred cycles on the AVR.
+static double benchmark(void (*filter)(int *, ParamData &), double *mapCalls) {
+  static int inputs[1024][8];
+  std::mt19937 rng(3);
+  std::uniform_int_distribution<int> value(-ADC_MAXVAL, ADC_MAXVAL);
+  for (auto &input : inputs) {
+    for (int &v : input) {
+      v = value(rng);
+    }
+  }
+  volatile int sink = 0;
+  const int rounds = 2000;
+  hostMapCalls = 0;
+  double start = hostNanoseconds();
+  for (int r = 0; r < rounds; r++) {
+    for (auto &input : inputs) {
+      int centered[8];
+      memcpy(centered, input, sizeof(centered));
+      filter(centered, par);
+      sink = sink + centered[r & 7];
+    }
+  }
+  double time = (hostNanoseconds() - start) / (rounds * 1024.0);
+  *mapCalls = hostMapCalls / (rounds * 1024.0);
+  return time;
+}
+
+int main() {
+  std::mt19937 rng(7); // fixed seed: the test is repeatable
+  long differences = 0;
+
+  // MINVALS and MAXVALS of the config files, small ranges around SCALE_MIN_RANGE and the largest ones
+  static const int16_t mins[] = {-1023, -700, -400, -350, -200, -100, -50, -33, -32, -31, -20, -17, -16};
+  static const int16_t maxs[] = {1023, 700, 400, 175, 100, 50, 33, 32, 31, 20, 17, 16};
+  static const int16_t deadzones[] = {0, 3, 15};
+  for (int16_t deadzone : deadzones) {
+    values.deadzone = deadzone;
+    for (int16_t mn : mins) {
+      for (int i = 0; i < 8; i++) {
+        values.minVals[i] = mn;
+        values.maxVals[i] = maxs[(i + (mn & 7)) % 12];
+      }
+      parametersChanged(par);
+      differences += compareAllInputs();
+    }
+  }
+
+  // random parameters, every channel has its own
+  std::uniform_int_distribution<int> range(1, 1023), deadzone(0, 15);
+  for (int n = 0; n < 300; n++) {
+    values.deadzone = deadzone(rng);
+    for (int i = 0; i < 8; i++) {
+      values.minVals[i] = -values.deadzone - range(rng);
+      values.maxVals[i] = values.deadzone + range(rng);
+    }
+    parametersChanged(par);
+    differences += compareAllInputs();
+  }
+  CHECK(differences == 0, "%ld inputs differ", differences);
+
+  // benchmark with the MINVALS and MAXVALS of config_sample.h
+  values.deadzone = 15;
+  for (int i = 0; i < 8; i++) {
+    values.minVals[i] = -400;
+    values.maxVals[i] = 175;
+  }
+  parametersChanged(par);
+  double scaledMaps, mappedMaps;
+  double scaled = benchmark(FilterAnalogReadOuts, &scaledMaps);
+  double mapped = benchmark(filterWithMap, &mappedMaps);
+  printf("channelScale: FilterAnalogReadOuts() %.2f divisions, %.1f ns, with map() %.2f divisions, %.1f ns per call "
+         "on this PC\n", scaledMaps, scaled, mappedMaps, mapped);
+  CHECK(scaledMaps == 0, "FilterAnalogReadOuts() still divides %.2f times per call", scaledMaps);
+
+  return testResult("channelScale");
+}
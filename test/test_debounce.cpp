@@ -0,0 +1,131 @@
+// Test of the debouncing of the keys in evalKeys() (spaceKeys.cpp) with bouncy synthetic traces:
+// every press and release bounces for up to 8 ms and a held key has short dropouts. Every press must
+// give exactly one keyOut event and one change of keyState, also every release, and the change must
+// be seen within the time of four samples after the key settled.
+
+#include <random>
+#include <vector>
+
+#define NUMKEYS 4
+#define KEYLIST {2, 3, 4, 5}
+#include "config.h"
+#include "test.h"
+
+#include "spaceKeys.cpp"
+
+struct Edge {
+  unsigned long start;  // first transition of the bounce [us]
+  unsigned long settle; // last transition of the bounce [us]
+  int pressed;
+};
+
+struct Trace {
+  std::vector<Edge> edges;                        // the intended presses and releases
+  std::vector<std::pair<unsigned long, int>> raw; // every transition of the pin: time, LOW/HIGH
+  size_t next = 0;                                // next raw transition
+  int level = HIGH;
+};
+
+// a bounce of up to 8 ms, which ends at the new level
+static unsigned long bounce(std::mt19937 &rng, Trace &trace, unsigned long t, int level) {
+  unsigned long start = t;
+  int bounces = rng() % 6;
+  for (int b = 0; b < bounces; b++) {
+    trace.raw.push_back({t, (b % 2) ? !level : level});
+    t += 200 + rng() % 1300;
+  }
+  trace.raw.push_back({t, level});
+  trace.edges.push_back({start, t, level == LOW});
+  return t;
+}
+
+static Trace makeTrace(std::mt19937 &rng, unsigned long duration) {
+  Trace trace;
+  unsigned long t = 100000 + rng() % 100000;
+  while (t < duration) {
+    t = bounce(rng, trace, t, LOW);
+    unsigned long release = t + 50000 + rng() % 250000;
+    // dropouts of at most 4 ms while the key is held, they are shorter than one sample period. The
+    // first one is after the press has been taken, a dropout before restarts the debouncing.
+    t += 20000;
+    while (t + 30000 < release) {
+      t += 20000 + rng() % 60000;
+      if (t + 10000 < release && rng() % 2) {
+        trace.raw.push_back({t, HIGH});
+        trace.raw.push_back({t + 500 + rng() % 3500, LOW});
+      }
+    }
+    t = bounce(rng, trace, release, HIGH);
+    t += 50000 + rng() % 250000;
+  }
+  return trace;
+}
+
+static void runTraces(unsigned long loopPeriod, uint32_t seed) {
+  std::mt19937 rng(seed);
+  const unsigned long duration = 20000000;
+  Trace traces[NUMKEYS];
+  for (int k = 0; k < NUMKEYS; k++) {
+    traces[k] = makeTrace(rng, duration);
+  }
+
+  int keyVals[NUMKEYS];
+  uint8_t keyOut[NUMKEYS] = {0};
+  uint8_t keyState[NUMKEYS] = {0};
+  size_t changes[NUMKEYS] = {0};
+  int presses[NUMKEYS] = {0};
+  int lateOrEarly = 0;
+  // the keys are sampled in the first loop after DEBOUNCE_SAMPLE_MS
+  unsigned long samplePeriod =
+      (DEBOUNCE_SAMPLE_MS * 1000 + loopPeriod - 1) / loopPeriod * loopPeriod;
+  hostMicros = 0;
+  while (hostMicros < duration + 500000) {
+    for (int k = 0; k < NUMKEYS; k++) {
+      Trace &tr = traces[k];
+      while (tr.next < tr.raw.size() && tr.raw[tr.next].first <= hostMicros) {
+        tr.level = tr.raw[tr.next++].second;
+      }
+      keyVals[k] = tr.level;
+    }
+    uint8_t before[NUMKEYS];
+    memcpy(before, keyState, NUMKEYS);
+    evalKeys(keyVals, keyOut, keyState);
+    for (int k = 0; k < NUMKEYS; k++) {
+      presses[k] += keyOut[k];
+      if (keyState[k] == before[k]) {
+        continue;
+      }
+      // the change must belong to the next intended edge and be seen after four samples: not before
+      // three sample periods after the first transition, but within five after the key settled
+      size_t i = changes[k]++;
+      if (i >= traces[k].edges.size()) {
+        continue;
+      }
+      const Edge &e = traces[k].edges[i];
+      unsigned long earliest = e.start + 3 * DEBOUNCE_SAMPLE_MS * 1000;
+      unsigned long latest = e.settle + 5 * samplePeriod;
+      if ((keyState[k] != e.pressed || hostMicros < earliest || hostMicros > latest) &&
+          lateOrEarly++ < 5) {
+        CHECK(false, "key %d, edge %zu at %lu us, settled %lu us: state %d at %lu us", k, i, e.start,
+              e.settle, keyState[k], hostMicros);
+      }
+    }
+    hostMicros += loopPeriod;
+  }
+  for (int k = 0; k < NUMKEYS; k++) {
+    int intendedPresses = (traces[k].edges.size() + 1) / 2;
+    CHECK(changes[k] == traces[k].edges.size(), "loop %lu us, key %d: %zu changes for %zu edges",
+          loopPeriod, k, changes[k], traces[k].edges.size());
+    CHECK(presses[k] == intendedPresses, "loop %lu us, key %d: %d keyOut events for %d presses",
+          loopPeriod, k, presses[k], intendedPresses);
+  }
+  CHECK(lateOrEarly == 0, "loop %lu us: %d changes too early or too late", loopPeriod, lateOrEarly);
+}
+
+int main() {
+  // fast and slow loops, the debouncing only depends on the time
+  runTraces(300, 1);
+  runTraces(1000, 2);
+  runTraces(3000, 3);
+  return testResult("debounce");
+}
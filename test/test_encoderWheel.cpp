@@ -0,0 +1,126 @@
+// Test of the encoder wheel (ROTARY_AXIS) in encoderWheel.cpp with a simulated encoder: the
+// transitions of the pins call the ISR at their time, loop() runs at 300 Hz and at 3 kHz. The
+// velocity must be exactly the same at the common points of time of both loops.
+
+#include <random>
+#include <vector>
+
+#define ROTARY_AXIS 3
+#include "config.h"
+#include "test.h"
+
+#include "encoderWheel.cpp"
+
+static ParamStorage values;
+static ParamData par = {.values = &values};
+
+// the pins of the encoder in the order of a positive step: CLK | DT << 1
+static const uint8_t quadrature[4] = {0, 2, 3, 1};
+
+struct Transition {
+  unsigned long us;
+  int step; // +1 or -1
+};
+
+// movement of the wheel: some fast and slow turns in both directions with random times
+static std::vector<Transition> makeMovement(uint32_t seed) {
+  std::mt19937 rng(seed);
+  std::vector<Transition> movement;
+  unsigned long t = 100000;
+  for (int turn = 0; turn < 12; turn++) {
+    int step = (rng() % 3 == 0) ? -1 : 1;
+    int transitions = 4 * (1 + rng() % 6); // 4 transitions per detent
+    unsigned long spacing = 500 + rng() % 20000;
+    for (int i = 0; i < transitions; i++) {
+      t += spacing / 2 + rng() % spacing;
+      movement.push_back({t, step});
+    }
+    t += rng() % 800000;
+  }
+  return movement;
+}
+
+// run loop() every periodUs with the movement of the wheel
+// returns the velocity of every loop
+static std::vector<int16_t> runWheel(const std::vector<Transition> &movement, unsigned long periodUs,
+                                     unsigned long duration) {
+  // reset the encoder and the velocity
+  encoderEventHead = encoderEventTail = 0;
+  encoderPosition = 0;
+  previousEncoderValue = 0;
+  simpull = 0;
+  int phase = 0;
+  hostPinLevel[ENCODER_CLK] = quadrature[0] & 1;
+  hostPinLevel[ENCODER_DT] = quadrature[0] >> 1;
+  hostMicros = 0;
+  initEncoderWheel();
+
+  std::vector<int16_t> result;
+  size_t next = 0;
+  for (unsigned long now = 0; now <= duration; now += periodUs) {
+    // the transitions since the last loop interrupt the loop at their time
+    while (next < movement.size() && movement[next].us <= now) {
+      hostMicros = movement[next].us;
+      phase = (phase + movement[next].step) & 3;
+      uint8_t pins = quadrature[phase];
+      bool clkChanged = hostPinLevel[ENCODER_CLK] != (pins & 1);
+      hostPinLevel[ENCODER_CLK] = pins & 1;
+      hostPinLevel[ENCODER_DT] = pins >> 1;
+      hostInterrupts[digitalPinToInterrupt(clkChanged ? ENCODER_CLK : ENCODER_DT)]();
+      next++;
+    }
+    hostMicros = now;
+    int16_t velocity[6] = {0};
+    calcEncoderWheel(velocity, false, par);
+    result.push_back(velocity[ROTARY_AXIS - 1]);
+  }
+  return result;
+}
+
+int main() {
+  const unsigned long fastPeriod = 333, slowPeriod = 3330; // 3 kHz and 300 Hz
+  const unsigned long duration = 12000000;
+  int differences = 0, moving = 0, maxVelocity = 0;
+  for (uint32_t seed = 1; seed <= 5; seed++) {
+    std::vector<Transition> movement = makeMovement(seed);
+    std::vector<int16_t> fast = runWheel(movement, fastPeriod, duration);
+    std::vector<int16_t> slow = runWheel(movement, slowPeriod, duration);
+    int position = 0;
+    for (const Transition &t : movement) {
+      position += t.step;
+    }
+    CHECK(encoderPosition == position, "seed %u: position %d instead of %d", seed, encoderPosition,
+          position);
+    for (size_t i = 0; i < slow.size(); i++) {
+      int16_t a = slow[i], b = fast[i * (slowPeriod / fastPeriod)];
+      if (a != b && differences++ < 5) {
+        CHECK(false, "seed %u, %lu ms: %d at 300 Hz, %d at 3 kHz", seed, i * slowPeriod / 1000, a,
+              b);
+      }
+      moving += (a != 0);
+      maxVelocity = max(maxVelocity, abs(a));
+    }
+  }
+  CHECK(differences == 0, "%d differences between 300 Hz and 3 kHz", differences);
+  CHECK(moving > 1000 && maxVelocity == 350, "%d loops with a velocity, at most %d", moving,
+        maxVelocity);
+
+  // one detent adds 4 * RAXIS_STR, but the velocity is limited to 350. After RAXIS_ECH ms, about a
+  // third is left. After many fast detents, the velocity fades out as fast as after one.
+  std::vector<Transition> detent;
+  for (int i = 0; i < 4; i++) {
+    detent.push_back({100000UL + 1000 * i, 1});
+  }
+  std::vector<int16_t> v = runWheel(detent, 1000, 400000);
+  CHECK(v[103] == 350 && v[103 + RAXIS_ECH] > 100 && v[103 + RAXIS_ECH] < 140,
+        "one detent: %d, %d after %d ms", v[103], v[103 + RAXIS_ECH], RAXIS_ECH);
+  std::vector<Transition> spin;
+  for (int i = 0; i < 200; i++) {
+    spin.push_back({100000UL + 1000 * i, 1});
+  }
+  v = runWheel(spin, 1000, 600000);
+  CHECK(v[299] == 350 && v[299 + RAXIS_ECH] > 100 && v[299 + RAXIS_ECH] < 140,
+        "fast spin: %d, %d after %d ms", v[299], v[299 + RAXIS_ECH], RAXIS_ECH);
+
+  return testResult("encoderWheel");
+}
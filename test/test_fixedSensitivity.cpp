@@ -0,0 +1,83 @@
+// Test of the fixed point sensitivities of KINEMATICS_FIXEDPOINT in kinematics.cpp: for every input, the
+// result may differ by one from the one of the floating point division. The test is compiled with
+// -fsingle-precision-constant and double is defined as float (see Makefile), because double is float on the AVR.
+
+#include <Arduino.h>
+#include "test.h"
+
+#define double float
+#define KINEMATICS_FIXEDPOINT
+#include "config.h"
+
+#include "kinematics.cpp"
+
+static_assert(sizeof(double) == 4, "double must be float, like on the AVR");
+
+static long inputs = 0, offByOne = 0; // inputs, whose result differs by one
+
+// check all inputs for one sensitivity, return the number of differences of more than one
+static long checkSensitivity(double sensitivity) {
+  FixedSensitivity fix = {};
+  buildFixedSensitivity(fix, sensitivity);
+  long differences = 0;
+  for (long v = -32768; v <= 32767; v++) {
+    // the floating point division without KINEMATICS_FIXEDPOINT, the results are clipped to +/-350 later.
+    // Quotients beyond the range of int16_t overflow there, these inputs aren't compared.
+    double quotient = v / sensitivity;
+    if (!(fabs(quotient) <= 32767)) {
+      continue;
+    }
+    long expected = constrain((int16_t)quotient, -TOTALSENSITIVITY, TOTALSENSITIVITY);
+    long result = constrain(applyFixedSensitivity(v, fix), -TOTALSENSITIVITY, TOTALSENSITIVITY);
+    inputs++;
+    offByOne += (result != expected);
+    if (abs(result - expected) > 1) {
+      if (differences == 0) {
+        CHECK(false, "sensitivity %.2f, input %ld: %ld instead of %ld", sensitivity, v, result, expected);
+      }
+      differences++;
+    }
+  }
+  return differences;
+}
+
+int main() {
+  // the sensitivities as they are parsed from the config.h or the parameter menu
+  char text[16];
+  long differences = 0;
+  int count = 0;
+  for (int i = 1; i <= 2000; i++) {
+    snprintf(text, sizeof(text), "%d.%02d", i / 100, i % 100);
+    differences += checkSensitivity(strtof(text, NULL));
+    count++;
+    if (i % 10 == 0) {
+      differences += checkSensitivity(-strtof(text, NULL));
+      count++;
+    }
+  }
+  printf("fixedSensitivity: %d sensitivities 0.01 ... 20.00 checked, %.3f%% of the results differ by one\n",
+         count, 100.0 * offByOne / inputs);
+  CHECK(differences == 0, "%ld inputs differ by more than one", differences);
+  CHECK(offByOne * 100 < inputs, "%ld of %ld inputs differ by one", offByOne, inputs);
+
+  // sensitivities, which are exact binary fractions, give exactly the quotient
+  static const double samples[] = {0.25, 0.5, 1.0, 2.0};
+  for (double sensitivity : samples) {
+    offByOne = 0;
+    checkSensitivity(sensitivity);
+    CHECK(offByOne == 0, "sensitivity %.2f: %ld results differ", sensitivity, offByOne);
+  }
+
+  // sensitivities, which are too small, are limited to 0.01
+  static const double others[] = {0.0, 0.005, -0.001};
+  FixedSensitivity fix = {};
+  for (double sensitivity : others) {
+    buildFixedSensitivity(fix, sensitivity);
+    int16_t result = applyFixedSensitivity(2, fix);
+    CHECK(abs(result) == 200 && (result < 0) == (sensitivity < 0), "2 / %.3f is %d", sensitivity, result);
+    CHECK(abs(applyFixedSensitivity(-32768, fix)) == TOTALSENSITIVITY, "-32768 / %.3f not limited", sensitivity);
+  }
+  CHECK(checkSensitivity(-0.5) == 0, "sensitivity -0.5 differs");
+
+  return testResult("fixedSensitivity");
+}
@@ -0,0 +1,80 @@
+// Test of ADV_HID_JIGGLE with ADV_HID_DELTA and ADV_HID_COMBINED in SpaceMouseHID.cpp: only the
+// keep-alive reports are jiggled and the next report sends the real values again. New values and a
+// report for a pressed or released key are sent as they are.
+
+#define ADV_HID_COMBINED
+#define ADV_HID_DELTA 1000
+#define ADV_HID_JIGGLE
+#define NUMKEYS 1
+#define KEYLIST {2}
+#define NUMHIDKEYS 1
+#define BUTTONLIST {SM_T}
+#include "config.h"
+#include "test.h"
+
+#include "SpaceMouseHID.cpp"
+
+static int reports = 0;
+static int16_t sentX[8];  // x of the reports since the last clearReports()
+static uint8_t lastKeys;  // first byte of the keys of the last report
+
+static void reportSent(const uint8_t *report, int len) {
+  if (reports < 8) {
+    sentX[reports] = report[1] | (report[2] << 8);
+  }
+  lastKeys = report[13];
+  reports++;
+}
+
+static void clearReports() {
+  reports = 0;
+  memset(sentX, 0, sizeof(sentX));
+}
+
+// run loop() every ms for durationMs with the joystick held still at x
+static void runLoop(int16_t x, uint8_t key, unsigned long durationMs) {
+  uint8_t keys[NUMKEYS] = {key};
+  for (unsigned long t = 0; t < durationMs; t++) {
+    SpaceMouseHID.startSample();
+    SpaceMouseHID.send_command(0, 0, 0, x, 0, 0, keys, 0);
+    hostMicros += 1000;
+  }
+}
+
+int main() {
+  hostUsbSent = reportSent;
+  hostMicros = 3000000;
+  runLoop(100, 0, 100);
+  CHECK(reports == 1 && sentX[0] == 100, "first report: %d reports, x = %d", reports, sentX[0]);
+
+  // pressing and releasing a key sends the keys with the same axes
+  clearReports();
+  runLoop(100, 1, 100);
+  CHECK(reports == 1 && sentX[0] == 100 && lastKeys == (1 << SM_T), "key pressed: %d reports, x = %d",
+        reports, sentX[0]);
+  clearReports();
+  runLoop(100, 0, 100);
+  CHECK(reports == 1 && sentX[0] == 100 && lastKeys == 0, "key released: %d reports, x = %d", reports,
+        sentX[0]);
+
+  // a change of the last bit is sent as it is and only once
+  clearReports();
+  runLoop(101, 0, 100);
+  CHECK(reports == 1 && sentX[0] == 101, "x from 100 to 101: %d reports, x = %d", reports, sentX[0]);
+
+  // the keep-alive after ADV_HID_DELTA ms is jiggled, the next report has the real value
+  clearReports();
+  runLoop(101, 0, ADV_HID_DELTA);
+  CHECK(reports == 2 && sentX[0] == 100 && sentX[1] == 101, "keep-alive: %d reports, x = %d, %d",
+        reports, sentX[0], sentX[1]);
+  clearReports();
+  runLoop(101, 1, 100);
+  CHECK(reports == 1 && sentX[0] == 101, "key pressed after a keep-alive: %d reports, x = %d", reports,
+        sentX[0]);
+  clearReports();
+  runLoop(101, 1, ADV_HID_DELTA);
+  CHECK(reports == 2 && sentX[0] == 100 && sentX[1] == 101, "second keep-alive: %d reports, x = %d, %d",
+        reports, sentX[0], sentX[1]);
+
+  return testResult("hidJiggle");
+}
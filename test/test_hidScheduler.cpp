@@ -0,0 +1,99 @@
+// Test of the scheduler of the HID reports in SpaceMouseHID.cpp with ADV_HID_SOF and a simulated
+// USB endpoint: one report per HID_RATE slot, sampled right at the start of the USB frame of its slot,
+// no burst after a busy endpoint and a continuous frame time, even if loop() was blocked for longer
+// than the 2048 ms of the USB frame number.
+
+#define ADV_HID_SOF
+#include "config.h"
+#include "test.h"
+
+#define private public // the frame time is checked directly
+#include "SpaceMouseHID.cpp"
+#undef private
+
+static int reports = 0;
+static unsigned long lastReportFrame; // frame time of the sample of the last report
+static int minSpacing, maxSpacing;     // frames between two reports
+static unsigned long maxFrameOffset;   // time from the start of the USB frame to the sample [us]
+
+// time to read the sensors and calculate the axes between startSample() and send_command()
+const unsigned long processingUs = 200;
+
+static void reportSent(const uint8_t *report, int len) {
+  unsigned long frame = SpaceMouseHID.sampleFrameTime;
+  if (reports > 0) {
+    int spacing = frame - lastReportFrame;
+    minSpacing = min(minSpacing, spacing);
+    maxSpacing = max(maxSpacing, spacing);
+  }
+  lastReportFrame = frame;
+  reports++;
+  // the stub counts the frames with millis(): a frame starts every 1000 us
+  maxFrameOffset = max(maxFrameOffset, SpaceMouseHID.sampleTime % 1000);
+}
+
+static void resetCount() {
+  reports = 0;
+  minSpacing = 100000;
+  maxSpacing = 0;
+  maxFrameOffset = 0;
+  memset(SpaceMouseHID.ageHistogram, 0, sizeof(SpaceMouseHID.ageHistogram));
+}
+
+// run loop() every periodUs for durationMs with a moving joystick
+static void runLoop(unsigned long periodUs, unsigned long durationMs) {
+  unsigned long end = hostMicros + durationMs * 1000;
+  while (hostMicros < end) {
+    unsigned long start = hostMicros;
+    SpaceMouseHID.startSample(); // may wait for the next frame
+    hostMicros += processingUs;
+    SpaceMouseHID.send_command(0, 0, 0, 100, 0, 0, NULL, 0);
+    hostMicros = max(hostMicros, start + periodUs);
+  }
+}
+
+int main() {
+  const int rate = HID_RATE;
+  hostUsbSent = reportSent;
+  hostMicros = 3000000; // after the calibration in setup()
+  runLoop(370, 100);
+
+  // one report per slot, the host takes every report at once
+  resetCount();
+  runLoop(370, 1000);
+  CHECK(reports >= 1000 / rate && reports <= 1000 / rate + 1, "%d reports in 1 s", reports);
+  CHECK(minSpacing == rate && maxSpacing == rate, "spacing %d ... %d frames", minSpacing, maxSpacing);
+  // every sample is taken right after the start of the frame of its slot, whatever the phase of
+  // loop() is, and sent after the processing: all reports are younger than 250 us
+  CHECK(maxFrameOffset < 10, "samples up to %lu us after the start of the frame", maxFrameOffset);
+  CHECK(SpaceMouseHID.ageHistogram[0] == reports, "%u of %d reports younger than 250 us",
+        SpaceMouseHID.ageHistogram[0], reports);
+
+  // the host doesn't take the reports for 50 ms: the next report is sent, as soon as the endpoint is
+  // free and the following one a whole slot later, not in a burst
+  unsigned long coalescedBefore = SpaceMouseHID.reportsCoalesced;
+  hostUsbSendSpace = 0;
+  runLoop(370, 50);
+  hostUsbSendSpace = USB_EP_SIZE;
+  // one superseded report per slot, not one per loop
+  unsigned long coalesced = SpaceMouseHID.reportsCoalesced - coalescedBefore;
+  CHECK(coalesced >= 50 / rate && coalesced <= 50 / rate + 1, "%lu reports coalesced in 50 ms", coalesced);
+  resetCount();
+  runLoop(370, 1000);
+  CHECK(minSpacing == rate, "spacing after a busy endpoint: %d frames", minSpacing);
+
+  // loop() is blocked for 5 s, e.g. by the serial menu: the frame number wrapped twice
+  unsigned long frameBefore = SpaceMouseHID.frameTime;
+  unsigned long msBefore = SpaceMouseHID.lastSampleMillis;
+  hostMicros += 5000000;
+  SpaceMouseHID.startSample();
+  CHECK(SpaceMouseHID.frameTime - frameBefore == millis() - msBefore,
+        "frame time after a blocked loop: %lu frames in %lu ms", SpaceMouseHID.frameTime - frameBefore,
+        millis() - msBefore);
+  resetCount();
+  runLoop(370, 1000);
+  CHECK(minSpacing == rate && maxSpacing == rate, "spacing after a blocked loop: %d ... %d frames",
+        minSpacing, maxSpacing);
+
+  return testResult("hidScheduler");
+}
@@ -0,0 +1,83 @@
+// Test of KEYS_ISR in spaceKeys.cpp: the edges of the keys on port B are captured by the simulated
+// pin change interrupt and replayed by evalKeys(). A short press during a long loop() is seen, the
+// state after an overflow of the ring buffer is right and a loop(), which was blocked for longer
+// than the 16 bit times of the edges, doesn't stop the replay.
+
+#define KEYS_ISR
+#define NUMKEYS 2
+#define KEYLIST {8, 9} // PB4 and PB5
+#include "config.h"
+#include "test.h"
+
+#include "spaceKeys.cpp"
+
+static int keyVals[NUMKEYS];
+static uint8_t keyOut[NUMKEYS];
+static uint8_t keyState[NUMKEYS];
+static int presses;
+
+// set the pin of key 0 and call the ISR like an edge
+static void key0(bool pressed) {
+  PINB = pressed ? (PINB & ~(1 << 4)) : (PINB | (1 << 4));
+  PCINT0_vect();
+}
+
+// run loop() every periodMs for durationMs
+static void runLoop(unsigned long periodMs, unsigned long durationMs) {
+  for (unsigned long t = 0; t < durationMs; t += periodMs) {
+    readAllFromKeys(keyVals);
+    evalKeys(keyVals, keyOut, keyState);
+    presses += keyOut[0];
+    hostMicros += periodMs * 1000;
+  }
+}
+
+int main() {
+  PINB = 0xFF; // released, pulled up
+  hostMicros = 3000000;
+  setupKeys();
+  runLoop(1, 100);
+
+  // a press of 40 ms during a loop() of 100 ms
+  presses = 0;
+  hostMicros += 20000;
+  key0(true);
+  hostMicros += 40000;
+  key0(false);
+  hostMicros += 40000;
+  runLoop(1, 100);
+  CHECK(presses == 1 && keyState[0] == 0, "short press in a long loop: %d presses", presses);
+
+  // a press of key 1 and 15 bouncing edges of key 0 in a long loop(): the ring buffer overflows at
+  // the last edge, the last stored edge is a release, but the key ends up pressed
+  presses = 0;
+  PINB &= ~(1 << 5);
+  PCINT0_vect();
+  for (int i = 0; i < 15; i++) {
+    hostMicros += 2000;
+    key0(i % 2 == 0);
+  }
+  CHECK(getKeyEventOverflows() == 1, "%u edges lost", getKeyEventOverflows());
+  runLoop(30, 600);
+  CHECK(keyState[0] == 1, "key not pressed after an overflow, slow loop");
+  key0(false);
+  runLoop(30, 600);
+  CHECK(keyState[0] == 0, "key not released after an overflow");
+
+  // the key is pressed and loop() is blocked for 40 s: the time of this edge can't be compared
+  presses = 0;
+  key0(true);
+  hostMicros += 40000000;
+  runLoop(30, 600);
+  CHECK(keyState[0] == 1, "key not pressed after a blocked loop");
+  CHECK(keyEventTail == keyEventHead, "edges left in the ring buffer after a blocked loop");
+  key0(false);
+  hostMicros += 40000;
+  key0(true);
+  hostMicros += 40000;
+  key0(false);
+  runLoop(30, 600);
+  CHECK(keyState[0] == 0 && presses == 2, "%d presses after a blocked loop", presses);
+
+  return testResult("keyEvents");
+}
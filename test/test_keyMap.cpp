@@ -0,0 +1,122 @@
+// Test of the key map in keyMap.cpp: short and long press, double tap, layer and chord, e.g. a key
+// of a chord, which is released before the other key is pressed, sends its button as a short press.
+
+#define NUMKEYS 5
+#define KEYLIST {2, 3, 4, 5, 6}
+#define KEYMAP
+#define KEYMAP_CHORDS 1
+// key 0 has a long press and a double tap, keys 1 and 2 are a chord, key 3 is the layer key
+#define KM_TAP    {SM_FIT, SM_T, SM_R, KM_LAYER, SM_F, SM_1, SM_2, SM_3, KM_NONE, SM_4}
+#define KM_HOLD \
+  {SM_MENU, KM_NONE, KM_NONE, KM_NONE, KM_NONE, KM_NONE, KM_NONE, KM_NONE, KM_NONE, KM_NONE}
+#define KM_DOUBLE {SM_ESC, KM_NONE, KM_NONE, KM_NONE, KM_NONE}
+#define KM_CHORD  {1, 2, SM_ROT}
+#define KM_TIMES  {400, 250, 50}
+#include "config.h"
+#include "test.h"
+
+#include "keyMap.cpp"
+
+static ParamStorage values;
+static ParamData par = {.values = &values};
+static uint8_t keyState[NUMKEYS];
+
+// run the key map once per ms for durationMs
+// returns the number of ms, in which the button was sent
+static int run(unsigned long durationMs, int8_t button) {
+  int sent = 0;
+  for (unsigned long t = 0; t < durationMs; t++) {
+    uint8_t keyData[4];
+    evalKeyMap(keyState, keyData, par, false);
+    if (keyData[button / 8] & (1 << (button % 8))) {
+      sent++;
+    }
+    hostMicros += 1000;
+  }
+  return sent;
+}
+
+// run the key map and count every button
+static void runAll(unsigned long durationMs, int counts[32]) {
+  memset(counts, 0, 32 * sizeof(int));
+  for (unsigned long t = 0; t < durationMs; t++) {
+    uint8_t keyData[4];
+    evalKeyMap(keyState, keyData, par, false);
+    for (int b = 0; b < 32; b++) {
+      counts[b] += (keyData[b / 8] >> (b % 8)) & 1;
+    }
+    hostMicros += 1000;
+  }
+}
+
+int main() {
+  int counts[32];
+  hostMicros = 3000000;
+  run(100, SM_F);
+
+  // a key without long press and double tap is sent from the second loop, as long as it is pressed
+  keyState[4] = 1;
+  CHECK(run(100, SM_F) == 99, "key 4 not sent while pressed");
+  keyState[4] = 0;
+  CHECK(run(100, SM_F) == 0, "key 4 sent after the release");
+
+  // short press of key 0: its button after the time of the double tap, for KEYMAP_TAP_MS
+  keyState[0] = 1;
+  runAll(100, counts);
+  CHECK(counts[SM_FIT] == 0 && counts[SM_MENU] == 0, "key 0 sent while pressed");
+  keyState[0] = 0;
+  CHECK(run(500, SM_FIT) == KEYMAP_TAP_MS, "short press of key 0");
+
+  // long press and double tap of key 0
+  keyState[0] = 1;
+  CHECK(run(600, SM_MENU) == 200, "long press of key 0");
+  keyState[0] = 0;
+  runAll(300, counts);
+  CHECK(counts[SM_FIT] == 0, "short press after a long press");
+  keyState[0] = 1;
+  run(50, SM_ESC);
+  keyState[0] = 0;
+  run(100, SM_ESC);
+  keyState[0] = 1;
+  CHECK(run(100, SM_ESC) == 100, "double tap of key 0");
+  keyState[0] = 0;
+  runAll(500, counts);
+  CHECK(counts[SM_FIT] == 0 && counts[SM_ESC] == 0, "double tap released");
+
+  // chord of keys 1 and 2: only the button of the chord
+  keyState[1] = 1;
+  run(20, SM_ROT);
+  keyState[2] = 1;
+  runAll(200, counts);
+  CHECK(counts[SM_ROT] >= 199 && counts[SM_T] == 0 && counts[SM_R] == 0, "chord: %d %d %d",
+        counts[SM_ROT], counts[SM_T], counts[SM_R]);
+  keyState[1] = 0;
+  keyState[2] = 0;
+  runAll(200, counts);
+  CHECK(counts[SM_ROT] == 0 && counts[SM_T] == 0 && counts[SM_R] == 0, "chord released");
+
+  // a key of the chord alone: a tap, which is released while waiting for the other key, is sent
+  // as a short press, a longer press is sent after the time of the chord until the release
+  keyState[1] = 1;
+  run(20, SM_T);
+  keyState[1] = 0;
+  CHECK(run(200, SM_T) == KEYMAP_TAP_MS, "tap of key 1 in the time of the chord");
+  keyState[2] = 1;
+  CHECK(run(200, SM_R) >= 149, "key 2 after the time of the chord");
+  keyState[2] = 0;
+  CHECK(run(200, SM_R) == 0, "key 2 released");
+
+  // layer: key 4 sends its button of the second layer, while the layer key is pressed
+  keyState[3] = 1;
+  run(20, SM_4);
+  keyState[4] = 1;
+  runAll(100, counts);
+  CHECK(counts[SM_4] == 99 && counts[SM_F] == 0, "key 4 in layer 1: %d %d", counts[SM_4],
+        counts[SM_F]);
+  keyState[3] = 0;
+  keyState[4] = 0;
+  runAll(100, counts);
+  CHECK(counts[SM_4] == 0 && counts[SM_F] == 0, "layer released");
+
+  return testResult("keyMap");
+}
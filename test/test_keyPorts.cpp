@@ -0,0 +1,59 @@
+// Test of readAllFromKeys() in spaceKeys.cpp, which reads the keys from the port registers of the
+// ATmega32U4: all 31 digital pins are keys and the port registers are set randomly. Every key must
+// have the level of its pin by the port map of the leonardo variant (pins_arduino.h).
+
+#include <random>
+
+#define NUMKEYS 31
+#define KEYLIST                                                                                    \
+  {0, 1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 12, 13, 14, 15, 16, 17, 18, 19, 20, 21, 22, 23, 24, 25, 26, \
+   27, 28, 29, 30}
+#include "config.h"
+#include "test.h"
+
+#include "spaceKeys.cpp"
+
+// port and bit of the digital pins in pins_arduino.h of the leonardo variant, e.g. D0 = PD2
+static const char *leonardoPins[31] = {
+    "D2", "D3", "D1", "D0", "D4", "C6", "D7", "E6", // D0..D7
+    "B4", "B5", "B6", "B7", "D6", "C7", "B3", "B1", // D8..D15
+    "B2", "B0", "F7", "F6", "F5", "F4", "F1", "F0", // D16..D23, A0..A5
+    "D4", "D7", "B4", "B5", "B6", "D6", "D5"};      // D24..D30, A6..A11 and TX LED
+
+static volatile uint8_t *portRegister(char port) {
+  switch (port) {
+  case 'B':
+    return &PINB;
+  case 'C':
+    return &PINC;
+  case 'D':
+    return &PIND;
+  case 'E':
+    return &PINE;
+  default:
+    return &PINF;
+  }
+}
+
+int main() {
+  std::mt19937 rng(20);
+  int errors = 0;
+  for (int round = 0; round < 10000; round++) {
+    PINB = rng();
+    PINC = rng();
+    PIND = rng();
+    PINE = rng();
+    PINF = rng();
+    int keyVals[NUMKEYS];
+    readAllFromKeys(keyVals);
+    for (int i = 0; i < NUMKEYS; i++) {
+      const char *pin = leonardoPins[i];
+      int expected = (*portRegister(pin[0]) >> (pin[1] - '0')) & 1;
+      if (keyVals[i] != expected && errors++ < 10) {
+        CHECK(false, "pin %d (P%s): %d instead of %d", i, pin, keyVals[i], expected);
+      }
+    }
+  }
+  CHECK(errors == 0, "%d wrong keys", errors);
+  return testResult("keyPorts");
+}
@@ -0,0 +1,120 @@
+// Regression test of the mixing matrix in kinematics.cpp: the preset matrices must give exactly the
+// velocities of the former hardcoded equations (copied below) for the joysticks and, compiled with
+// HALLEFFECT (see Makefile), for the hall effect sensors. The elements of MIX only take values of int8_t.
+
+#include <random> // before Arduino.h with its min() and max() macros
+
+#define ENABLE_PROGMODE 1
+#include "config.h"
+#include "test.h"
+
+#include "kinematics.cpp"
+#include "parameterMenu.cpp"
+
+static ParamStorage values;
+static ParamData par = {.values = &values, .arrays = {{PARAM_TYPE_BYTE, "MIX", values.mixMatrix, 6 * 8}}};
+
+// _calculateKinematicSensors() of the version before the mixing matrix
+static void formerKinematicSensors(int *centered, int16_t *velocity, bool prio_z_exclusive) {
+#ifndef HALLEFFECT
+  int cntN = 0;
+  int cntP = 0;
+  if(centered[AX] < 0){cntN += 1;} if(centered[AX] > 0){cntP += 1;}
+  if(centered[BX] < 0){cntN += 1;} if(centered[BX] > 0){cntP += 1;}
+  if(centered[CX] < 0){cntN += 1;} if(centered[CX] > 0){cntP += 1;}
+  if(centered[DX] < 0){cntN += 1;} if(centered[DX] > 0){cntP += 1;}
+
+    bool zMove = ((cntP >= 3 && cntN == 0) || (cntN >= 3 && cntP == 0));
+
+    velocity[TRANSX] = (-centered[CY] +centered[AY]);
+    velocity[TRANSY] = (-centered[BY] +centered[DY]);
+    velocity[TRANSZ] = (-centered[AX] -centered[BX] -centered[CX] -centered[DX]);
+
+    if (prio_z_exclusive && zMove) // if a z-move is detected, make the rotations zero
+    {
+      velocity[ROTX] = 0;
+      velocity[ROTY] = 0;
+      velocity[ROTZ] = 0;
+    }
+    else
+    {
+      velocity[ROTX] = (-centered[CX] + centered[AX]);
+      velocity[ROTY] = (-centered[BX] + centered[DX]);
+      velocity[ROTZ] = (+centered[AY] + centered[BY] + centered[CY] + centered[DY]);
+    }
+#else
+    velocity[TRANSX] = (centered[HES1] -centered[HES0] +centered[HES6] -centered[HES7]) / 2;
+    velocity[TRANSY] = (centered[HES2] -centered[HES3] +centered[HES9] -centered[HES8]) / 2;
+    velocity[TRANSZ] = (centered[HES0] +centered[HES1] +centered[HES2] +centered[HES3] +centered[HES6] +centered[HES7] +centered[HES8] +centered[HES9]) / 4;
+    velocity[ROTX]   = (centered[HES0] +centered[HES1] -centered[HES6] -centered[HES7]) / 2;
+    velocity[ROTY]   = (centered[HES8] +centered[HES9] -centered[HES2] -centered[HES3]) / 2;
+    velocity[ROTZ]   = (centered[HES0] +centered[HES2] +centered[HES6] +centered[HES8] -centered[HES1] -centered[HES3] -centered[HES7] -centered[HES9]) / 4;
+#endif
+}
+
+// compare both for one set of centered values, return true if they are the same
+static bool compare(const int *input, const char *what) {
+  int centered[8];
+  int16_t expected[6], velocity[6];
+  memcpy(centered, input, sizeof(centered));
+  formerKinematicSensors(centered, expected, values.exclusiveMode);
+  _calculateKinematicSensors(centered, velocity, par);
+  bool same = (memcmp(expected, velocity, sizeof(velocity)) == 0);
+  CHECK(same, "%s: {%d, %d, %d, %d, %d, %d, %d, %d} -> {%d, %d, %d, %d, %d, %d} instead of {%d, %d, %d, %d, %d, %d}",
+        what, input[0], input[1], input[2], input[3], input[4], input[5], input[6], input[7], velocity[0],
+        velocity[1], velocity[2], velocity[3], velocity[4], velocity[5], expected[0], expected[1], expected[2],
+        expected[3], expected[4], expected[5]);
+  return same;
+}
+
+int main() {
+  std::mt19937 rng(5); // fixed seed: the test is repeatable
+  int centered[8];
+  long differences = 0;
+
+  for (int exclusive = 0; exclusive <= 1; exclusive++) {
+    values.exclusiveMode = exclusive;
+
+    // the output of FilterAnalogReadOuts(): +/-350 and beyond, small values around zero for the z-move detection
+    std::uniform_int_distribution<int> full(-400, 400), small(-3, 3);
+    for (long n = 0; n < 1000000 && differences < 10; n++) {
+      for (int i = 0; i < 8; i++) {
+        centered[i] = (n % 4 == 0) ? small(rng) : full(rng);
+      }
+      differences += !compare(centered, exclusive ? "PRIO-Z-EXCLUSIVE" : "random");
+    }
+
+    // all combinations of the extreme values, odd values test the truncation of the hall effect equations
+    static const int extremes[] = {-351, -350, -1, 0, 1, 349, 350};
+    for (long n = 0; n < 5764801L && differences < 10; n++) { // 7^8
+      long k = n;
+      for (int i = 0; i < 8; i++, k /= 7) {
+        centered[i] = extremes[k % 7];
+      }
+      differences += !compare(centered, "extremes");
+    }
+  }
+
+  // the elements of MIX are int8_t, ProgMode refuses values, which don't fit
+  values.mixMatrix[0] = 1;
+  prog = {'p', 100, PE_OK};
+  executeProgCommand(par);
+  prog.cmd = 'w';
+  prog.value = 200;
+  executeProgCommand(par);
+  CHECK(prog.retval == PE_INVALID_VALUE && values.mixMatrix[0] == 1, ">w200 on MIX: %d, MIX[0] = %d",
+        (int)prog.retval, values.mixMatrix[0]);
+  prog.value = -128;
+  prog.retval = PE_OK;
+  executeProgCommand(par);
+  CHECK(prog.retval == PE_OK && values.mixMatrix[0] == -128, ">w-128 on MIX: %d, MIX[0] = %d",
+        (int)prog.retval, values.mixMatrix[0]);
+  writeParameter(100, -300, par); // the parameter menu
+  CHECK(values.mixMatrix[0] == -128, "MIX[0] = %d after -300", values.mixMatrix[0]);
+
+#ifdef HALLEFFECT
+  return testResult("mixMatrix (hall effect sensors)");
+#else
+  return testResult("mixMatrix (joysticks)");
+#endif
+}
@@ -0,0 +1,100 @@
+// Test and benchmark of the lookup table of the modifier function in kinematics.cpp:
+// modifierTable() must stay within one count of modifierFunction() for every input and every
+// reasonable curve, and it is rebuilt by parametersChanged(), not in the kinematics.
+
+#include "config.h"
+#include "test.h"
+
+#include "kinematics.cpp"
+#include "parameterMenu.cpp"
+
+static ParamStorage values;
+static ParamData par = {.values = &values};
+
+// set the parameters of the curve like writeParameter() does
+static void setCurve(int8_t modFunc, double a, double b) {
+  values.modFunc = modFunc;
+  values.slope_at_zero = a;
+  values.slope_at_end = b;
+  parametersChanged(par);
+}
+
+static int maxError() {
+  int maxErr = 0;
+  for (int x = -TOTALSENSITIVITY - 10; x <= TOTALSENSITIVITY + 10; x++) {
+    int err = abs(modifierTable(x, par) - modifierFunction(x, par));
+    maxErr = max(maxErr, err);
+  }
+  return maxErr;
+}
+
+static int knots() {
+  int n = 1;
+  while (modTableX[n - 1] != TOTALSENSITIVITY) {
+    n++;
+  }
+  return n;
+}
+
+// time per call in ns on the PC
+static double benchmark(int (*func)(int, ParamData &)) {
+  volatile int sink = 0;
+  const int rounds = 200;
+  double start = hostNanoseconds();
+  for (int r = 0; r < rounds; r++) {
+    for (int x = -TOTALSENSITIVITY; x <= TOTALSENSITIVITY; x++) {
+      sink = sink + func(x, par);
+    }
+  }
+  return (hostNanoseconds() - start) / (rounds * (2 * TOTALSENSITIVITY + 1));
+}
+
+int main() {
+  // all reasonable curves: a = 0.5 ... 3, b up to 1.57
+  static const double slopesA[] = {0.5, 0.8, 1.0, 1.15, 1.5, 2.0, 2.5, 3.0};
+  static const double slopesB[] = {0.2, 0.5, 1.0, 1.15, 1.3, 1.45, 1.5, 1.57};
+  int worstKnots = 0;
+
+  setCurve(0, 1.0, 1.0);
+  CHECK(maxError() == 0, "linear function: error %d", maxError());
+  CHECK(knots() == 2, "linear function: %d knots", knots());
+
+  for (double a : slopesA) {
+    setCurve(1, a, 1.0);
+    CHECK(maxError() <= 1, "MODFUNC 1, MOD_A %.2f: error %d", a, maxError());
+    worstKnots = max(worstKnots, knots());
+    for (double b : slopesB) {
+      setCurve(3, a, b);
+      CHECK(maxError() <= 1, "MODFUNC 3, MOD_A %.2f, MOD_B %.2f: error %d", a, b, maxError());
+      worstKnots = max(worstKnots, knots());
+    }
+  }
+  printf("modifierTable: at most %d of %d knots used\n", worstKnots, MODTABLE_KNOTS);
+
+  // the table follows the parameters, also if only one of them changes
+  setCurve(3, 1.15, 1.15);
+  int before = modifierTable(200, par);
+  values.slope_at_end = 1.5;
+  parametersChanged(par);
+  CHECK(modifierTable(200, par) != before, "the table wasn't rebuilt after MOD_B changed");
+  CHECK(maxError() <= 1, "error %d after MOD_B changed", maxError());
+
+  // changing another parameter keeps the table, a change of the values without parametersChanged(), too
+  int16_t x1 = modTableX[1];
+  values.deadzone = 20;
+  parametersChanged(par);
+  CHECK(modTableX[1] == x1, "the table was rebuilt for another parameter");
+  values.slope_at_end = 1.0;
+  modifierTable(200, par);
+  CHECK(modTableX[1] == x1, "the table was rebuilt in the kinematics");
+
+  // benchmark with the default curve of config_sample.h
+  setCurve(3, 1.15, 1.15);
+  double function = benchmark(modifierFunction);
+  double table = benchmark(modifierTable);
+  printf("modifierTable: %.1f ns per call, modifierFunction: %.1f ns per call on this PC (%.0fx)\n",
+         table, function, function / table);
+  CHECK(table < function, "the table is slower than the function");
+
+  return testResult("modifierTable");
+}
@@ -0,0 +1,81 @@
+// Test of the oversampling and decimation of readAllFromJoystick() with ADC_OVERSAMPLING
+// (compiled with 16 and with 4, see Makefile): synthetic noisy samples of a slow ramp are read and
+// the effective resolution is compared to a single conversion per value.
+
+#include <random> // before Arduino.h with its min() and max() macros
+
+#ifndef ADC_OVERSAMPLING
+#define ADC_OVERSAMPLING 16
+#endif
+#define INVERTLIST {0, 1, 0, 0, 0, 0, 0, 0}
+#include "config.h"
+#include "test.h"
+
+#include "kinematics.cpp"
+
+static double voltage;        // input of the simulated ADC in counts of the 10 bit ADC
+static double noise = 0.5;    // standard deviation of the noise in counts
+static std::mt19937 rng(1234); // fixed seed: the test is repeatable
+static std::normal_distribution<double> gauss(0.0, 1.0);
+
+static int convert(uint8_t pin) {
+  long value = lround(voltage + noise * gauss(rng));
+  return constrain(value, 0L, 1023L);
+}
+
+// standard deviation of the error of the values from the ideal ones in counts of the 10 bit ADC
+static double errorOfRamp(bool oversampling, double *bias) {
+  double sum = 0, sumSq = 0;
+  long n = 0;
+  int raw[8];
+  for (voltage = 100.0; voltage < 900.0; voltage += 1.0 / 64) {
+    double error;
+    if (oversampling) {
+      readAllFromJoystick(raw, true);
+      error = (double)raw[0] / ADC_SCALE - voltage;
+    } else {
+      error = convert(A0) - voltage;
+    }
+    sum += error;
+    sumSq += error * error;
+    n++;
+  }
+  *bias = sum / n;
+  return sqrt(sumSq / n - *bias * *bias);
+}
+
+int main() {
+  int raw[8];
+  hostAnalogRead = convert;
+
+  // full scale: no overflow of the sum, the inverted channel covers the full range, too
+  noise = 0;
+  voltage = 1023;
+  readAllFromJoystick(raw, true);
+  CHECK(raw[0] == ADC_MAXVAL, "full scale is %d instead of %d", raw[0], ADC_MAXVAL);
+  CHECK(raw[1] == 0, "inverted full scale is %d instead of 0", raw[1]);
+  voltage = 0;
+  readAllFromJoystick(raw, true);
+  CHECK(raw[0] == 0, "zero is %d", raw[0]);
+  CHECK(raw[1] == ADC_MAXVAL, "inverted zero is %d instead of %d", raw[1], ADC_MAXVAL);
+
+  // effective resolution with half a count of noise: every four times the conversions give one bit
+  noise = 0.5;
+  double biasSingle, biasOversampled;
+  double single = errorOfRamp(false, &biasSingle);
+  double oversampled = errorOfRamp(true, &biasOversampled);
+  double gain = log2(single / oversampled);
+  printf("oversampling %d: error %.3f counts (single conversion %.3f), %.2f bits gained\n",
+         ADC_SAMPLES, oversampled, single, gain);
+  CHECK(gain > ADC_EXTRA_BITS - 0.25, "gain of %.2f bits, expected %d", gain, ADC_EXTRA_BITS);
+  // the decimation truncates: the values are at most one 10 bit count too small
+  CHECK(biasOversampled <= 0.0 && biasOversampled > -0.5, "bias %.3f counts", biasOversampled);
+
+  // without noise, the oversampling can't resolve anything between two counts
+  noise = 0;
+  voltage = 500.4;
+  readAllFromJoystick(raw, true);
+  CHECK(raw[0] == 500 * ADC_SCALE, "500.4 without noise is %d", raw[0]);
+
+  return testResult("oversampling");
+}
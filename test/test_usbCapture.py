@@ -0,0 +1,114 @@
+# Test of the HID reports of ADV_HID_SPACENAV against the capture of a real SpaceNavigator in
+# Reverse-Engineering-Docs/, see test/Makefile. The capture is decoded by progModePy/usbCapture.py and the requests of
+# the host (LED output reports, SET_REPORT) are replayed into SpaceMouseHID.cpp by bin/usbReplay (usbReplay.cpp).
+# The report ids and lengths of the firmware must match the report descriptor of the SpaceNavigator, the reports must
+# follow the cadence of HID_RATE and the firmware must follow the LED and the "Calibrate" of the host.
+#
+# usage: python3 test_usbCapture.py [bin/usbReplay]
+
+import inspect
+import os
+import subprocess
+import sys
+
+here = os.path.dirname(os.path.abspath(__file__))
+sys.path.insert(0, os.path.join(here, "..", "progModePy"))
+import usbCapture  # noqa: E402
+
+CAPTURE = os.path.join(here, "..", "Reverse-Engineering-Docs", "SpaceNavigator-Connected-Calibrate.pcapng")
+
+failures = 0
+
+
+def check(condition, message):
+    """Print the failure like CHECK() of test.h and continue with the test"""
+    global failures
+    if not condition:
+        failures += 1
+        print(f"test_usbCapture.py:{inspect.currentframe().f_back.f_lineno}: failed: {message}")
+
+
+def replay(program, requests):
+    """Replay the requests of the host into the firmware, return its lines split into fields"""
+    start = requests[0].time
+    lines = []
+    for r in requests:
+        micros = round((r.time - start) * 1e6)
+        if r.transfer == "interrupt":
+            lines.append(f"O {micros} {r.data.hex(' ')}")
+        else:
+            reportType = {"output": 2, "feature": 3}[r.transfer.split()[1]]
+            lines.append(f"S {micros} {reportType} {r.data.hex(' ')}")
+    output = subprocess.run([program], input="\n".join(lines) + "\n", capture_output=True, text=True, check=True)
+    return [line.split() for line in output.stdout.splitlines() if line]
+
+
+def main():
+    program = sys.argv[1] if len(sys.argv) > 1 else os.path.join(here, "bin", "usbReplay")
+    reports = usbCapture.readSource(CAPTURE)
+    descriptors = usbCapture.readDescriptors(CAPTURE)
+    layout = usbCapture.reportLayout(descriptors[(usbCapture.DESCRIPTOR_HID_REPORT, 0)])
+    captureEndpoints = usbCapture.endpoints(descriptors[(usbCapture.DESCRIPTOR_CONFIGURATION, 0)])
+
+    requests = [r for r in reports if r.direction == "out"]
+    output = replay(program, requests)
+    start = int(next(f for f in output if f[0] == "T")[1])  # micros() of the firmware at the first request
+
+    # the reports of the firmware are a subset of the reports of the SpaceNavigator
+    ours = usbCapture.reportLayout(bytes(int(v, 16) for v in next(f for f in output if f[0] == "D")[1:]))
+    for key, length in sorted(ours.items()):
+        check(layout.get(key) == length, f"{key[0]} report {key[1]}: {length} bytes, {layout.get(key)} in the capture")
+    for key in (("input", 1), ("input", 2), ("input", 3), ("output", 4), ("feature", 7)):
+        check(key in ours, f"{key[0]} report {key[1]} of the capture is missing")
+
+    # the same endpoints: interrupt IN and OUT
+    interface = bytes(int(v, 16) for v in next(f for f in output if f[0] == "I")[1:])
+    ourEndpoints = usbCapture.endpoints(interface)
+    for address, (attributes, _, _) in captureEndpoints.items():
+        check(address in ourEndpoints and ourEndpoints[address][0] == attributes,
+              f"endpoint {address:#04x}: {ourEndpoints.get(address)} instead of attributes {attributes}")
+
+    # every input report has the id and the length of the descriptor of the SpaceNavigator
+    rate = int(next(f for f in output if f[0] == "H")[1])
+    sent = [(int(f[1]), bytes(int(v, 16) for v in f[2:])) for f in output if f[0] == "R"]
+    check(len(sent) > 500, f"only {len(sent)} input reports")
+    for micros, data in sent:
+        if layout.get(("input", data[0])) != len(data):
+            check(False, f"input report {data.hex(' ')} at {micros} us: {layout.get(('input', data[0]))} bytes")
+            break
+
+    # cadence: the translation in every HID_RATE slot, unless the keys take it, the rotation of the same sample
+    # in the next frame, the keys only after a change
+    translation = [micros for micros, data in sent if data[0] == 1]
+    intervals = [(b - a) / 1000 for a, b in zip(translation, translation[1:])]
+    check(min(intervals) == rate and all(i % rate == 0 for i in intervals) and max(intervals) <= 2 * rate,
+          f"intervals of report 1: {min(intervals)} ... {max(intervals)} ms for HID_RATE {rate}")
+    for (micros, data), (nextMicros, nextData) in zip(sent, sent[1:]):
+        if data[0] == 1 and (nextData[0] != 2 or nextMicros - micros != 1000):
+            check(False, f"report {nextData[0]} {nextMicros - micros} us after report 1 at {micros} us")
+            break
+    keys = [data for _, data in sent if data[0] == 3]
+    check(all(a != b for a, b in zip(keys, keys[1:])), "report 3 without a change of the keys")
+
+    # the LED follows the output reports of the host, the "Calibrate" starts a calibration
+    led = {int(f[1]) - start: int(f[2]) for f in output if f[0] == "L"}
+    state = False
+    for request in requests:
+        micros = round((request.time - requests[0].time) * 1e6)
+        if request.transfer == "interrupt" and request.id == 4:
+            changed = bool(request.data[1] & 1) != state
+            state = bool(request.data[1] & 1)
+            seen = [t for t in led if 0 <= t - micros <= 1000]
+            check(changed == bool(seen), f"LED {'on' if state else 'off'} at {micros} us: {len(seen)} changes")
+    calibrations = [int(f[1]) - start for f in output if f[0] == "C"]
+    calibrate = [round((r.time - requests[0].time) * 1e6) for r in requests if r.id == 7]
+    check(len(calibrations) == len(calibrate) == 1 and 0 <= calibrations[0] - calibrate[0] <= 1000,
+          f"calibration requested at {calibrations} us, sent at {calibrate} us")
+
+    print(f"usbCapture: {len(sent)} input reports, {len(requests)} requests of the host replayed")
+    print(f"usbCapture: {'FAILED' if failures else 'passed'}")
+    return 1 if failures else 0
+
+
+if __name__ == "__main__":
+    sys.exit(main())
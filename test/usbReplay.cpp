@@ -0,0 +1,129 @@
+// Replay of the requests of the host in a USB capture into SpaceMouseHID.cpp with
+// ADV_HID_SPACENAV, run by test_usbCapture.py. It is no test of its own: it prints the
+// descriptors and every report of the firmware in the format of progModePy/usbCapture.py,
+// which compares them with the capture.
+//
+// input (stdin), sorted by time:
+//   O <time in us> <report in hex>            output report of the host on the OUT endpoint
+//   S <time in us> <type> <report in hex>     SET_REPORT request, type 2 = output, 3 = feature
+// output (stdout):
+//   D <hex>                                   report descriptor
+//   I <hex>                                   interface, HID and endpoint descriptors
+//   H <ms>                                    HID_RATE
+//   T <time in us>                            micros() at the first request of the host
+//   R <time in us> <report in hex>            input report, like debug mode 72
+//   L <time in us> <0 or 1>                   LED state after an output report
+//   C <time in us>                            the host requested a calibration
+
+#define ADV_HID_SPACENAV
+#define NUMKEYS 2
+#define KEYLIST {2, 3}
+#define NUMHIDKEYS 2
+#define BUTTONLIST {SM_MENU, SM_FIT}
+#include "config.h"
+
+#define private public // the descriptors are requested directly
+#define protected public
+#include "SpaceMouseHID.cpp"
+#undef private
+#undef protected
+
+static void printHex(const uint8_t *data, int len) {
+  for (int i = 0; i < len; i++) {
+    printf(" %02X", data[i]);
+  }
+  printf("\n");
+}
+
+static void reportSent(const uint8_t *report, int len) {
+  printf("R %lu", micros());
+  printHex(report, len);
+}
+
+static void descriptorSent(const uint8_t *data, int len) {
+  printHex(data, len);
+}
+
+// one loop() of the firmware: the knob moves slowly, the first key is pressed every other second
+static void runLoop() {
+  unsigned long ms = millis();
+  int16_t x = (ms / 50) % 200 - 100;
+  uint8_t keys[NUMKEYS] = {(uint8_t)((ms / 1000) % 2), 0};
+  SpaceMouseHID.startSample();
+  SpaceMouseHID.send_command(-x, 0, x / 2, x, 10, -x, keys, 0);
+  bool led = SpaceMouseHID.getLEDState();
+  if (SpaceMouseHID.updateLEDState() != led) {
+    printf("L %lu %d\n", micros(), !led);
+  }
+  if (SpaceMouseHID.takeCalibrateRequest()) {
+    printf("C %lu\n", micros());
+  }
+}
+
+// parse the hex bytes of a line, return their number
+static int parseHex(const char *text, uint8_t *data, int maxLen) {
+  int len = 0;
+  unsigned int value;
+  int consumed;
+  while (len < maxLen && sscanf(text, "%x%n", &value, &consumed) == 1) {
+    data[len++] = value;
+    text += consumed;
+  }
+  return len;
+}
+
+int main() {
+  hostMicros = 3000000; // after the calibration in setup()
+  hostUsbControlSent = descriptorSent;
+  printf("D");
+  USBSetup descriptorRequest = {REQUEST_DEVICETOHOST_STANDARD_INTERFACE, 6, 0,
+                                HID_REPORT_DESCRIPTOR_TYPE, 0, 0xFF};
+  SpaceMouseHID.getDescriptor(descriptorRequest);
+  printf("I");
+  uint8_t interfaces = 0;
+  SpaceMouseHID.getInterface(&interfaces);
+  hostUsbControlSent = nullptr;
+  printf("H %u\n", SpaceMouseHID.getReportRate());
+  hostUsbSent = reportSent;
+
+  char line[256];
+  unsigned long start = 0;
+  while (fgets(line, sizeof(line), stdin)) {
+    char kind = line[0];
+    unsigned long time;
+    int type = 0, offset = 0;
+    if (!(kind == 'O' && sscanf(line, "O %lu%n", &time, &offset) == 1) &&
+        !(kind == 'S' && sscanf(line, "S %lu %d%n", &time, &type, &offset) == 2)) {
+      continue;
+    }
+    uint8_t report[USB_EP_SIZE];
+    int len = parseHex(line + offset, report, sizeof(report));
+    if (start == 0) {
+      start = hostMicros - time;
+      printf("T %lu\n", start);
+    }
+    // run loop() every ms until the request of the host
+    while (hostMicros < start + time) {
+      runLoop();
+      hostMicros += 1000;
+    }
+    if (kind == 'O') {
+      memcpy(hostUsbOut, report, len);
+      hostUsbOutLen = len;
+      hostUsbOutRead = 0;
+    } else if (kind == 'S') {
+      USBSetup request = {REQUEST_HOSTTODEVICE_CLASS_INTERFACE, HID_SET_REPORT, report[0],
+                          (uint8_t)type, 0, (uint16_t)len};
+      hostUsbControlData = report;
+      hostUsbControlLen = len;
+      SpaceMouseHID.setup(request);
+      hostUsbControlData = nullptr;
+    }
+  }
+  // one more second after the last request
+  for (int i = 0; i < 1000; i++) {
+    runLoop();
+    hostMicros += 1000;
+  }
+  return 0;
+}
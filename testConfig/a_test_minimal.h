@@ -92,7 +92,7 @@
 #error "Index of killkeys must be smaller than the total number of keys"
 #endif
 
-#define DEBOUNCE_KEYS_MS 200
+#define DEBOUNCE_SAMPLE_MS 5
 
 #define ENCODER_CLK 2
 #define ENCODER_DT 3
@@ -92,7 +92,7 @@
 #error "Index of killkeys must be smaller than the total number of keys"
 #endif
 
-#define DEBOUNCE_KEYS_MS 200
+#define DEBOUNCE_SAMPLE_MS 5
 
 #define ENCODER_CLK 2
 #define ENCODER_DT 3
@@ -117,4 +117,7 @@
 
 #define HIDMAXBUTTONS 32
 
+#define ADV_HID_JIGGLE
+#define ADV_HID_DELTA 1000
+
 #endif // CONFIG_h
\ No newline at end of file
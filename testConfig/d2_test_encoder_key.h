@@ -89,7 +89,7 @@
 #error "Index of killkeys must be smaller than the total number of keys"
 #endif
 
-#define DEBOUNCE_KEYS_MS 200
+#define DEBOUNCE_SAMPLE_MS 5
 
 #define ENCODER_CLK 2
 #define ENCODER_DT 3
@@ -114,4 +114,7 @@
 
 #define HIDMAXBUTTONS 32
 
+#define ADV_HID_COMBINED
+#define ADV_HID_SOF
+
 #endif // CONFIG_h
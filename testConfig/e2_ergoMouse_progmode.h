@@ -85,7 +85,7 @@
 #define KILLROT 2
 #define KILLTRANS 3
 
-#define DEBOUNCE_KEYS_MS 200
+#define DEBOUNCE_SAMPLE_MS 5
 
 #define ENCODER_CLK 0
 #define ENCODER_DT 1
@@ -83,7 +83,7 @@
 #define KILLROT 2
 #define KILLTRANS 3
 
-#define DEBOUNCE_KEYS_MS 200
+#define DEBOUNCE_SAMPLE_MS 5
 
 #define ENCODER_CLK 0
 #define ENCODER_DT 1
@@ -109,4 +109,7 @@
 
 #define HIDMAXBUTTONS 32
 
+#define ADV_HID_SPACENAV
+#define KEYS_ISR
+
 #endif // CONFIG_h
@@ -52,6 +52,9 @@
 #define COMP_MDIFF 4
 #define COMP_CDIFF 50
 
+#define FAST_START
+#define RECENTER_INTERVAL 60
+
 #define EXCLUSIVE 0
 #define EXCL_HYST 5
 #define EXCL_PRIOZ 0
@@ -90,7 +93,7 @@
 #error "Index of killkeys must be smaller than the total number of keys"
 #endif
 
-#define DEBOUNCE_KEYS_MS 200
+#define DEBOUNCE_SAMPLE_MS 5
 
 #define ENCODER_CLK 2
 #define ENCODER_DT 3
@@ -115,4 +118,6 @@
 
 #define HIDMAXBUTTONS 32
 
+#define ADV_HID_PARAMS
+
 #endif // CONFIG_h